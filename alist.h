@@ -4,19 +4,25 @@
 #define ALIST_H_INCLUDED 1
 
 #include <stdlib.h>
+#include <string.h>
+#include "container.h"
 
 #define ALIST_PROTO(T, N) \
 	typedef struct N N; \
-	typedef int N##_iterator; \
+	typedef container_size N##_iterator; \
 	N *N##_new(void); \
-	N *N##_new_cap(int size); \
+	N *N##_new_cap(container_size size); \
 	void N##_free(N *s); \
-	int N##_size(const N *s); \
-	int N##_insert(N *s, T item, int pos); \
-	T N##_pop(N *s, int pos); \
-	T N##_get(const N *s, int pos); \
-	void N##_set(N *s, T item, int pos); \
-	int N##_resize(N *s, int size); \
+	int N##_init(N *s); \
+	int N##_init_cap(N *s, container_size size); \
+	void N##_destroy(N *s); \
+	container_size N##_size(const N *s); \
+	int N##_insert(N *s, T item, container_size pos); \
+	T N##_pop(N *s, container_size pos); \
+	T N##_get(const N *s, container_size pos); \
+	void N##_set(N *s, T item, container_size pos); \
+	int N##_resize(N *s, container_size size); \
+	int N##_shrink_to_fit(N *s); \
 	N##_iterator N##_iterate(const N *s); \
 	int N##_next(const N *s, N##_iterator *iter); \
 	T N##_get_at(const N *s, N##_iterator iter); \
@@ -26,41 +32,195 @@
 
 /* defines functions for an arraylist with elements of type T named N */
 #define ALIST(T, N) \
-	struct N { int cap; int len; T *arr; }; \
+	ALIST_STRUCT(T, N); \
+	ALIST_FUNCTIONS(T, N)
+
+/*
+ * ALIST split in two: ALIST_STRUCT defines struct N, so it can go in a header
+ * after ALIST_PROTO for a list embedded by value in another struct, and
+ * ALIST_FUNCTIONS then defines the functions in one .c file
+ */
+#define ALIST_STRUCT(T, N) \
+	struct N { container_size cap; container_size len; T *arr; }
+
+#define ALIST_FUNCTIONS(T, N) \
+	int N##_alloc_(N *s, container_size size) \
+	{ \
+		/* malloc(0) and realloc(p, 0) may return NULL, keep at least one element */ \
+		if (size < 1) size = 1; \
+		if (CONTAINER_OVERFLOWS(size, sizeof(T))) return 0; \
+		s->arr = CONTAINER_MALLOC(size * sizeof(T)); \
+		s->cap = size; \
+		return s->arr != NULL; \
+	} \
+	int N##_realloc_(N *s, container_size size) \
+	{ \
+		T *temp; \
+		if (size < 1) size = 1; \
+		if (CONTAINER_OVERFLOWS(size, sizeof(T))) return 0; \
+		temp = CONTAINER_REALLOC(s->arr, size * sizeof(T)); \
+		if (!temp) return 0; \
+		s->arr = temp; \
+		s->cap = size; \
+		return 1; \
+	} \
+	void N##_dealloc_(N *s) \
+	{ \
+		CONTAINER_FREE(s->arr); \
+	} \
+	ALIST_BODY_(T, N, 8)
+
+/*
+ * same as ALIST, but s->arr is always aligned to ALIGN bytes (a power of two),
+ * e.g. 64 for a cache line or 32 for AVX loads; ALIST_PROTO declares its functions
+ */
+#define ALIST_ALIGNED(T, N, ALIGN) \
+	struct N { container_size cap; container_size len; T *arr; void *mem; }; \
+	/* whether size elements and the alignment padding fit in a size_t */ \
+	int N##_fits_(container_size size) \
+	{ \
+		return !CONTAINER_OVERFLOWS(size, sizeof(T)) && size * sizeof(T) <= (size_t)-1 - (ALIGN); \
+	} \
+	int N##_alloc_(N *s, container_size size) \
+	{ \
+		if (!N##_fits_(size)) return 0; \
+		s->mem = CONTAINER_MALLOC(size * sizeof(T) + (ALIGN) - 1); \
+		if (!s->mem) return 0; \
+		s->arr = (T *)(((uintptr_t)s->mem + (ALIGN) - 1) & ~(uintptr_t)((ALIGN) - 1)); \
+		s->cap = size; \
+		return 1; \
+	} \
+	int N##_realloc_(N *s, container_size size) \
+	{ \
+		char *mem, *arr; \
+		size_t offset; \
+		if (!N##_fits_(size)) return 0; \
+		offset = (char *)s->arr - (char *)s->mem; \
+		mem = CONTAINER_REALLOC(s->mem, size * sizeof(T) + (ALIGN) - 1); \
+		if (!mem) return 0; \
+		/* realloc only keeps malloc's alignment, move the elements if it changed */ \
+		arr = (char *)(((uintptr_t)mem + (ALIGN) - 1) & ~(uintptr_t)((ALIGN) - 1)); \
+		if (arr != mem + offset) { \
+			memmove(arr, mem + offset, (size < s->len ? size : s->len) * sizeof(T)); \
+		} \
+		s->mem = mem; \
+		s->arr = (T *)arr; \
+		s->cap = size; \
+		return 1; \
+	} \
+	void N##_dealloc_(N *s) \
+	{ \
+		CONTAINER_FREE(s->mem); \
+	} \
+	ALIST_BODY_(T, N, 8)
+
+/* header entries for a small alist, same as ALIST_PROTO */
+#define SMALL_ALIST_PROTO(T, N) \
+	ALIST_PROTO(T, N)
+
+/*
+ * defines functions for an arraylist which stores up to INLINE_N (at least 2)
+ * elements in the struct itself and moves them to a malloc'd array only when it
+ * grows past that; a list embedded in another struct or on the stack and
+ * initialized with N##_init doesn't allocate until then; while the elements
+ * are inline, arr points into the struct, so the struct must not be copied or
+ * moved
+ */
+#define SMALL_ALIST(T, N, INLINE_N) \
+	struct N { container_size cap; container_size len; T *arr; T inline_arr[INLINE_N]; }; \
+	int N##_alloc_(N *s, container_size size) \
+	{ \
+		if (size <= (INLINE_N)) { \
+			s->arr = s->inline_arr; \
+			s->cap = (INLINE_N); \
+			return 1; \
+		} \
+		if (CONTAINER_OVERFLOWS(size, sizeof(T))) return 0; \
+		s->arr = CONTAINER_MALLOC(size * sizeof(T)); \
+		s->cap = size; \
+		return s->arr != NULL; \
+	} \
+	int N##_realloc_(N *s, container_size size) \
+	{ \
+		T *temp; \
+		if (s->arr == s->inline_arr) { \
+			if (size <= (INLINE_N)) return 1; \
+			if (CONTAINER_OVERFLOWS(size, sizeof(T))) return 0; \
+			temp = CONTAINER_MALLOC(size * sizeof(T)); \
+			if (!temp) return 0; \
+			memcpy(temp, s->inline_arr, s->len * sizeof(T)); \
+		} else if (size <= (INLINE_N)) { \
+			memcpy(s->inline_arr, s->arr, (size < s->len ? size : s->len) * sizeof(T)); \
+			CONTAINER_FREE(s->arr); \
+			s->arr = s->inline_arr; \
+			s->cap = (INLINE_N); \
+			return 1; \
+		} else { \
+			if (CONTAINER_OVERFLOWS(size, sizeof(T))) return 0; \
+			temp = CONTAINER_REALLOC(s->arr, size * sizeof(T)); \
+			if (!temp) return 0; \
+		} \
+		s->arr = temp; \
+		s->cap = size; \
+		return 1; \
+	} \
+	void N##_dealloc_(N *s) \
+	{ \
+		if (s->arr != s->inline_arr) CONTAINER_FREE(s->arr); \
+	} \
+	ALIST_BODY_(T, N, (INLINE_N))
+
+/*
+ * the functions shared by all alist variants; these need struct N with fields
+ * cap, len and arr and functions to manage the storage of arr:
+ * int N##_alloc_(N *s, container_size size) to allocate it,
+ * int N##_realloc_(N *s, container_size size) to change its capacity keeping
+ * the first min(size, len) elements (both set cap to the new capacity, which
+ * may differ from size, and return 0 on failure, also when size elements don't
+ * fit in memory) and void N##_dealloc_(N *s) to free it; CAP is the capacity
+ * used by N##_new
+ */
+#define ALIST_BODY_(T, N, CAP) \
 	const int N##_sizeof_element = sizeof(T); \
 	N *N##_new(void) \
 	{ \
-		return N##_new_cap(8); \
+		return N##_new_cap(CAP); \
 	} \
-	N *N##_new_cap(int size) \
+	N *N##_new_cap(container_size size) \
 	{ \
 		N *s; \
-		s = malloc(sizeof(struct N)); \
+		s = CONTAINER_MALLOC(sizeof(struct N)); \
 		if (!s) return NULL; \
-		s->cap = size; \
-		s->len = 0; \
-		s->arr = malloc(size * N##_sizeof_element); \
-		if (!s->arr) { free(s); return NULL; } \
+		if (!N##_init_cap(s, size)) { CONTAINER_FREE(s); return NULL; } \
 		return s; \
 	} \
 	void N##_free(N *s) \
 	{ \
-		free(s->arr); \
-		free(s); \
+		N##_destroy(s); \
+		CONTAINER_FREE(s); \
 	} \
-	int N##_size(const N *s) \
+	int N##_init(N *s) \
+	{ \
+		return N##_init_cap(s, CAP); \
+	} \
+	int N##_init_cap(N *s, container_size size) \
+	{ \
+		s->len = 0; \
+		return N##_alloc_(s, size); \
+	} \
+	void N##_destroy(N *s) \
+	{ \
+		N##_dealloc_(s); \
+	} \
+	container_size N##_size(const N *s) \
 	{ \
 		return s->len; \
 	} \
-	int N##_insert(N *s, T item, int pos) \
+	int N##_insert(N *s, T item, container_size pos) \
 	{ \
-		T *temp; \
-		int i; \
+		container_size i; \
 		if (s->len >= s->cap) { \
-			temp = realloc(s->arr, s->cap*1.5*N##_sizeof_element); \
-			if (!temp) return 0; \
-			s->arr = temp; \
-			s->cap *= 1.5; \
+			if (s->cap == CONTAINER_SIZE_MAX || !N##_realloc_(s, CONTAINER_GROW(s->cap))) return 0; \
 		} \
 		if (pos >= 0 && pos != s->len) { \
 			for (i=s->len; i>pos; --i) { \
@@ -71,11 +231,11 @@
 		s->len++; \
 		return 1; \
 	} \
-	T N##_pop(N *s, int pos) \
+	T N##_pop(N *s, container_size pos) \
 	{ \
 		T temp; \
-		int i; \
-		if (pos < 0) return s->arr[s->len-1]; \
+		container_size i; \
+		if (pos < 0) return s->arr[--s->len]; \
 		temp = s->arr[pos]; \
 		for (i=pos; i<s->len-1; ++i) { \
 			s->arr[i] = s->arr[i+1]; \
@@ -83,24 +243,28 @@
 		--s->len; \
 		return temp; \
 	} \
-	T N##_get(const N *s, int pos) \
+	T N##_get(const N *s, container_size pos) \
 	{ \
 		return s->arr[pos<0||pos>=s->len?s->len-1:pos]; \
 	} \
-	void N##_set(N *s, T item, int pos) \
+	void N##_set(N *s, T item, container_size pos) \
 	{ \
 		s->arr[pos<0||pos>=s->len?s->len-1:pos] = item; \
 	} \
-	int N##_resize(N *s, int size) \
+	int N##_resize(N *s, container_size size) \
 	{ \
-		T *temp; \
-		temp = realloc(s->arr, size*N##_sizeof_element); \
-		if (!temp) return 0; \
-		s->arr = temp; \
+		if (!N##_realloc_(s, size)) return 0; \
 		if (size < s->len) s->len = size; \
-		s->cap = size; \
 		return 1; \
 	} \
+	/* reallocs the capacity to the length, but at least 1 so that inserts can grow it */ \
+	int N##_shrink_to_fit(N *s) \
+	{ \
+		container_size size; \
+		size = s->len > 0 ? s->len : 1; \
+		if (s->cap <= size) return 1; \
+		return N##_realloc_(s, size); \
+	} \
 	N##_iterator N##_iterate(const N *s) \
 	{ \
 		return -1; \
@@ -135,4 +299,393 @@
 	} \
 	struct N /* to avoid extra semicolon outside of a function */
 
+#ifdef __GNUC__
+#define ALIST_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define ALIST_PREFETCH(p) ((void)0)
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define ALIST_RESTRICT restrict
+#elif defined(__GNUC__)
+#define ALIST_RESTRICT __restrict__
+#else
+#define ALIST_RESTRICT
+#endif
+
+#define ALIST_LANES 8 /* independent accumulators in ALIST_NUMERIC reductions */
+#define ALIST_SORT_THRESHOLD 16 /* ranges up to this length are left for the final insertion sort */
+
+/* header entries for the sorting and searching functions of an alist named N */
+#define ALIST_SORT_PROTO(T, N) \
+	void N##_sort(N *s); \
+	container_size N##_lower_bound(const N *s, T item); \
+	container_size N##_binary_search(const N *s, T item); \
+	T *N##_eytzinger(const N *s); \
+	container_size N##_eytzinger_search(T const *eyt, container_size len, T item)
+
+/*
+ * defines an introsort and binary searches for an alist N defined by ALIST(T, N);
+ * C(a, b) compares two elements like the comparator of HMAP, it's expanded
+ * directly in the generated code, so it can be a macro as well as a function
+ */
+#define ALIST_SORT(T, N, C) \
+	int N##_compare(T _alist_a, T _alist_b) \
+	{ \
+		return C(_alist_a, _alist_b); \
+	} \
+	ALIST_SEARCH_(T, N) \
+	void N##_sort(N *s) \
+	{ \
+		N##_introsort_(s->arr, s->len); \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+/* header entries for the radix sort of an alist named N, same functions as ALIST_SORT_PROTO */
+#define ALIST_RADIX_SORT_PROTO(T, N) \
+	ALIST_SORT_PROTO(T, N)
+
+/*
+ * defines the functions of ALIST_SORT with N##_sort implemented as an LSD radix
+ * sort; uint32_t KEY(T item) extracts the sort key (e.g. `(uint32_t)x ^ 0x80000000`
+ * for signed 32-bit integers) and the elements are ordered by their keys;
+ * N##_sort falls back to introsort when it can't allocate its buffer
+ */
+#define ALIST_RADIX_SORT(T, N, KEY) \
+	int N##_compare(T _alist_a, T _alist_b) \
+	{ \
+		uint32_t a, b; \
+		a = KEY(_alist_a); \
+		b = KEY(_alist_b); \
+		return a < b ? -1 : a > b; \
+	} \
+	ALIST_SEARCH_(T, N) \
+	void N##_sort(N *s) \
+	{ \
+		T *src; \
+		T *dst; \
+		T *tmp; \
+		container_size count[4][256]; \
+		container_size i, pass, sum, c; \
+		uint32_t key; \
+		if (s->len <= ALIST_SORT_THRESHOLD) { \
+			N##_insertion_sort_(s->arr, s->len); \
+			return; \
+		} \
+		tmp = CONTAINER_MALLOC(s->len * sizeof(T)); \
+		if (!tmp) { \
+			N##_introsort_(s->arr, s->len); \
+			return; \
+		} \
+		memset(count, 0, sizeof(count)); \
+		for (i=0; i<s->len; ++i) { \
+			key = KEY(s->arr[i]); \
+			++count[0][key & 0xff]; \
+			++count[1][(key >> 8) & 0xff]; \
+			++count[2][(key >> 16) & 0xff]; \
+			++count[3][key >> 24]; \
+		} \
+		src = s->arr; \
+		dst = tmp; \
+		for (pass=0; pass<4; ++pass) { \
+			/* all keys share this byte, the pass wouldn't move anything */ \
+			if (count[pass][(KEY(src[0]) >> 8*pass) & 0xff] == s->len) continue; \
+			for (i=0, sum=0; i<256; ++i) { \
+				c = count[pass][i]; \
+				count[pass][i] = sum; \
+				sum += c; \
+			} \
+			for (i=0; i<s->len; ++i) { \
+				dst[count[pass][(KEY(src[i]) >> 8*pass) & 0xff]++] = src[i]; \
+			} \
+			tmp = src; \
+			src = dst; \
+			dst = tmp; \
+		} \
+		if (src != s->arr) { \
+			memcpy(s->arr, src, s->len * sizeof(T)); \
+			CONTAINER_FREE(src); \
+		} else { \
+			CONTAINER_FREE(dst); \
+		} \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+/* the parts of ALIST_SORT and ALIST_RADIX_SORT using N##_compare */
+#define ALIST_SEARCH_(T, N) \
+	int N##_log2_(container_size n) \
+	{ \
+		container_size i; \
+		for (i=0; n>1; n>>=1) ++i; \
+		return i; \
+	} \
+	void N##_insertion_sort_(T *arr, container_size len) \
+	{ \
+		T item; \
+		container_size i, j; \
+		for (i=1; i<len; ++i) { \
+			item = arr[i]; \
+			for (j=i; j>0 && N##_compare(item, arr[j-1]) < 0; --j) { \
+				arr[j] = arr[j-1]; \
+			} \
+			arr[j] = item; \
+		} \
+	} \
+	void N##_sift_down_(T *arr, container_size pos, container_size len) \
+	{ \
+		T item; \
+		container_size child; \
+		item = arr[pos]; \
+		while ((child = 2*pos+1) < len) { \
+			if (child+1 < len && N##_compare(arr[child], arr[child+1]) < 0) ++child; \
+			if (N##_compare(item, arr[child]) >= 0) break; \
+			arr[pos] = arr[child]; \
+			pos = child; \
+		} \
+		arr[pos] = item; \
+	} \
+	void N##_heapsort_(T *arr, container_size len) \
+	{ \
+		T item; \
+		container_size i; \
+		for (i=len/2-1; i>=0; --i) N##_sift_down_(arr, i, len); \
+		for (i=len-1; i>0; --i) { \
+			item = arr[0]; \
+			arr[0] = arr[i]; \
+			arr[i] = item; \
+			N##_sift_down_(arr, 0, i); \
+		} \
+	} \
+	void N##_introsort_range_(T *arr, container_size lo, container_size hi, int depth) \
+	{ \
+		T pivot; \
+		T item; \
+		container_size i, j, mid; \
+		while (hi-lo > ALIST_SORT_THRESHOLD) { \
+			if (depth-- == 0) { \
+				N##_heapsort_(arr+lo, hi-lo); \
+				return; \
+			} \
+			/* median of three, also leaves sentinels on both ends */ \
+			mid = lo + (hi-lo)/2; \
+			if (N##_compare(arr[mid], arr[lo]) < 0) { item = arr[mid]; arr[mid] = arr[lo]; arr[lo] = item; } \
+			if (N##_compare(arr[hi-1], arr[mid]) < 0) { item = arr[mid]; arr[mid] = arr[hi-1]; arr[hi-1] = item; } \
+			if (N##_compare(arr[mid], arr[lo]) < 0) { item = arr[mid]; arr[mid] = arr[lo]; arr[lo] = item; } \
+			pivot = arr[mid]; \
+			i = lo; \
+			j = hi-1; \
+			for (;;) { \
+				do ++i; while (N##_compare(arr[i], pivot) < 0); \
+				do --j; while (N##_compare(pivot, arr[j]) < 0); \
+				if (i >= j) break; \
+				item = arr[i]; \
+				arr[i] = arr[j]; \
+				arr[j] = item; \
+			} \
+			/* recurse into the smaller part to bound the stack depth */ \
+			if (i-lo < hi-i) { \
+				N##_introsort_range_(arr, lo, i, depth); \
+				lo = i; \
+			} else { \
+				N##_introsort_range_(arr, i, hi, depth); \
+				hi = i; \
+			} \
+		} \
+	} \
+	void N##_introsort_(T *arr, container_size len) \
+	{ \
+		N##_introsort_range_(arr, 0, len, 2*N##_log2_(len)); \
+		N##_insertion_sort_(arr, len); \
+	} \
+	container_size N##_lower_bound(const N *s, T item) \
+	{ \
+		T const *base; \
+		container_size n, half; \
+		if (s->len == 0) return 0; \
+		base = s->arr; \
+		for (n=s->len; n>1; n-=half) { \
+			half = n/2; \
+			base = N##_compare(base[half-1], item) < 0 ? base+half : base; \
+		} \
+		return (base - s->arr) + (N##_compare(*base, item) < 0); \
+	} \
+	container_size N##_binary_search(const N *s, T item) \
+	{ \
+		container_size i; \
+		i = N##_lower_bound(s, item); \
+		return i < s->len && !N##_compare(s->arr[i], item) ? i : -1; \
+	} \
+	container_size N##_eytzinger_fill_(T const *src, T *eyt, container_size i, container_size k, container_size len) \
+	{ \
+		if (k <= len) { \
+			i = N##_eytzinger_fill_(src, eyt, i, 2*k, len); \
+			eyt[k] = src[i++]; \
+			i = N##_eytzinger_fill_(src, eyt, i, 2*k+1, len); \
+		} \
+		return i; \
+	} \
+	T *N##_eytzinger(const N *s) \
+	{ \
+		T *eyt; \
+		eyt = CONTAINER_MALLOC((s->len+1) * sizeof(T)); \
+		if (!eyt) return NULL; \
+		N##_eytzinger_fill_(s->arr, eyt, 0, 1, s->len); \
+		return eyt; \
+	} \
+	container_size N##_eytzinger_search(T const *eyt, container_size len, T item) \
+	{ \
+		container_size k; \
+		for (k=1; k<=len; ) { \
+			ALIST_PREFETCH(eyt + 16*(size_t)k); \
+			k = 2*k + (N##_compare(eyt[k], item) < 0); \
+		} \
+		/* undo the right turns taken after the last left one */ \
+		while (k & 1) k >>= 1; \
+		return k >> 1; \
+	}
+
+/* header entries for the bulk operations of an alist of arithmetic type T named N */
+#define ALIST_NUMERIC_PROTO(T, N) \
+	void N##_fill(N *s, T value); \
+	container_size N##_find(const N *s, T value); \
+	container_size N##_count(const N *s, T value); \
+	T N##_min(const N *s); \
+	T N##_max(const N *s); \
+	T N##_sum(const N *s); \
+	void N##_prefix_sum(N *s); \
+	int N##_filter_into(const N *s, N *out, T min, T max)
+
+/*
+ * defines bulk operations for an alist N of an arithmetic type T defined by
+ * ALIST(T, N); the loops are written so that compilers vectorize them (-O3 or
+ * -O2 -ftree-vectorize with GCC): no aliasing, no early exits inside the inner
+ * loops and reductions split into ALIST_LANES independent accumulators, which
+ * also vectorizes floating point reductions without -ffast-math
+ */
+#define ALIST_NUMERIC(T, N) \
+	void N##_fill(N *s, T value) \
+	{ \
+		T *ALIST_RESTRICT arr; \
+		container_size i, len; \
+		arr = s->arr; \
+		len = s->len; \
+		for (i=0; i<len; ++i) arr[i] = value; \
+	} \
+	container_size N##_find(const N *s, T value) \
+	{ \
+		const T *ALIST_RESTRICT arr; \
+		container_size i, j, len; \
+		int found; \
+		arr = s->arr; \
+		len = s->len; \
+		for (i=0; i+ALIST_LANES*2<=len; i+=ALIST_LANES*2) { \
+			found = 0; \
+			for (j=0; j<ALIST_LANES*2; ++j) found |= arr[i+j] == value; \
+			if (found) break; \
+		} \
+		for (; i<len; ++i) { \
+			if (arr[i] == value) return i; \
+		} \
+		return -1; \
+	} \
+	container_size N##_count(const N *s, T value) \
+	{ \
+		const T *ALIST_RESTRICT arr; \
+		container_size i, len, count; \
+		arr = s->arr; \
+		len = s->len; \
+		count = 0; \
+		for (i=0; i<len; ++i) count += arr[i] == value; \
+		return count; \
+	} \
+	T N##_min(const N *s) \
+	{ \
+		const T *ALIST_RESTRICT arr; \
+		T acc[ALIST_LANES]; \
+		container_size i, j, len; \
+		arr = s->arr; \
+		len = s->len; \
+		if (len == 0) return 0; \
+		for (j=0; j<ALIST_LANES; ++j) acc[j] = arr[0]; \
+		for (i=0; i+ALIST_LANES<=len; i+=ALIST_LANES) { \
+			for (j=0; j<ALIST_LANES; ++j) acc[j] = arr[i+j] < acc[j] ? arr[i+j] : acc[j]; \
+		} \
+		for (; i<len; ++i) acc[0] = arr[i] < acc[0] ? arr[i] : acc[0]; \
+		for (j=1; j<ALIST_LANES; ++j) acc[0] = acc[j] < acc[0] ? acc[j] : acc[0]; \
+		return acc[0]; \
+	} \
+	T N##_max(const N *s) \
+	{ \
+		const T *ALIST_RESTRICT arr; \
+		T acc[ALIST_LANES]; \
+		container_size i, j, len; \
+		arr = s->arr; \
+		len = s->len; \
+		if (len == 0) return 0; \
+		for (j=0; j<ALIST_LANES; ++j) acc[j] = arr[0]; \
+		for (i=0; i+ALIST_LANES<=len; i+=ALIST_LANES) { \
+			for (j=0; j<ALIST_LANES; ++j) acc[j] = arr[i+j] > acc[j] ? arr[i+j] : acc[j]; \
+		} \
+		for (; i<len; ++i) acc[0] = arr[i] > acc[0] ? arr[i] : acc[0]; \
+		for (j=1; j<ALIST_LANES; ++j) acc[0] = acc[j] > acc[0] ? acc[j] : acc[0]; \
+		return acc[0]; \
+	} \
+	T N##_sum(const N *s) \
+	{ \
+		const T *ALIST_RESTRICT arr; \
+		T acc[ALIST_LANES]; \
+		container_size i, j, len; \
+		arr = s->arr; \
+		len = s->len; \
+		for (j=0; j<ALIST_LANES; ++j) acc[j] = 0; \
+		for (i=0; i+ALIST_LANES<=len; i+=ALIST_LANES) { \
+			for (j=0; j<ALIST_LANES; ++j) acc[j] += arr[i+j]; \
+		} \
+		for (; i<len; ++i) acc[0] += arr[i]; \
+		for (j=1; j<ALIST_LANES; ++j) acc[0] += acc[j]; \
+		return acc[0]; \
+	} \
+	void N##_prefix_sum(N *s) \
+	{ \
+		T *ALIST_RESTRICT arr; \
+		T sum; \
+		container_size i, len; \
+		arr = s->arr; \
+		len = s->len; \
+		sum = 0; \
+		for (i=0; i<len; ++i) { \
+			sum += arr[i]; \
+			arr[i] = sum; \
+		} \
+	} \
+	int N##_filter_into(const N *s, N *out, T min, T max) \
+	{ \
+		const T *ALIST_RESTRICT arr; \
+		T *ALIST_RESTRICT dst; \
+		T *inplace; \
+		container_size i, j, len; \
+		len = s->len; \
+		if (s == out) { \
+			/* filtering in place, the restrict pointers below would alias */ \
+			inplace = out->arr; \
+			for (i=0, j=0; i<len; ++i) { \
+				inplace[j] = inplace[i]; \
+				j += (inplace[i] >= min) & (inplace[i] <= max); \
+			} \
+			out->len = j; \
+			return 1; \
+		} \
+		if (out->cap - out->len < len && !N##_resize(out, out->len + len)) return 0; \
+		arr = s->arr; \
+		dst = out->arr; \
+		/* branchless: every element is stored, but only the matching ones are kept */ \
+		for (i=0, j=out->len; i<len; ++i) { \
+			dst[j] = arr[i]; \
+			j += (arr[i] >= min) & (arr[i] <= max); \
+		} \
+		out->len = j; \
+		return 1; \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
 #endif /* ifndef ALIST_H_INCLUDED */
@@ -0,0 +1,711 @@
+/* art.h: a CPP-based template implementation of adaptive radix tree */
+
+#ifndef ART_H_INCLUDED
+#define ART_H_INCLUDED 1
+
+#include <stdlib.h>
+#include <string.h>
+#include "container.h"
+
+/* the inner node types, by the number of children they have room for */
+#define ART_NODE4 0
+#define ART_NODE16 1
+#define ART_NODE48 2
+#define ART_NODE256 3
+
+/* a smaller node replaces a larger one once it has this many children left */
+#define ART_SHRINK16 3
+#define ART_SHRINK48 12
+#define ART_SHRINK256 40
+
+/* write x to the 4 or 8 bytes at buf most significant first, so integer keys sort by value */
+#define ART_KEY32(buf, x) ( \
+	(buf)[0] = (unsigned char)((x) >> 24), (buf)[1] = (unsigned char)((x) >> 16), \
+	(buf)[2] = (unsigned char)((x) >> 8), (buf)[3] = (unsigned char)(x))
+#define ART_KEY64(buf, x) ( \
+	ART_KEY32(buf, (x) >> 32), ART_KEY32((buf) + 4, (x) & 0xffffffffU))
+
+/*
+ * the header of the inner nodes; the children are leaves or nodes, leaf
+ * pointers have their lowest bit set; a node is followed by its prefix
+ */
+typedef struct art_node {
+	unsigned char type; /* ART_NODE4 etc. */
+	unsigned short count; /* the number of children */
+	size_t prefix_len; /* the number of key bytes all keys below share after the byte leading here */
+	void *end; /* the leaf (not tagged) of the key ending after the prefix or NULL */
+} art_node;
+
+/* the keys of node4 and node16 are sorted, node48 maps key bytes to children + 1 */
+typedef struct art_node4 { art_node n; unsigned char keys[4]; void *children[4]; } art_node4;
+typedef struct art_node16 { art_node n; unsigned char keys[16]; void *children[16]; } art_node16;
+typedef struct art_node48 { art_node n; unsigned char index[256]; void *children[48]; } art_node48;
+typedef struct art_node256 { art_node n; void *children[256]; } art_node256;
+
+#define ART_NODE_SIZE_(type) ((type) == ART_NODE4 ? sizeof(art_node4) : (type) == ART_NODE16 ? sizeof(art_node16) \
+	: (type) == ART_NODE48 ? sizeof(art_node48) : sizeof(art_node256))
+#define ART_NODE_CAP_(type) ((type) == ART_NODE4 ? 4 : (type) == ART_NODE16 ? 16 : (type) == ART_NODE48 ? 48 : 256)
+#define ART_PREFIX_(node) ((unsigned char *)(node) + ART_NODE_SIZE_((node)->type))
+#define ART_IS_LEAF_(p) ((uintptr_t)(p) & 1)
+#define ART_TAG_(leaf) ((void *)((uintptr_t)(leaf) + 1))
+#define ART_UNTAG_(p) ((void *)((uintptr_t)(p) - 1))
+/* the key bytes of a leaf after the byte leading to it */
+#define ART_SUFFIX_(leaf) ((unsigned char *)((leaf) + 1))
+
+#define ART_PROTO(V, N) \
+	typedef struct N N; \
+	typedef struct N##_leaf N##_leaf; \
+	typedef struct N##_walker_ N##_walker_; \
+	typedef int (*N##_visit)(const char *key, size_t len, V *value, void *ctx); \
+	N *N##_new(void); \
+	void N##_free(N *t); \
+	int N##_init(N *t); \
+	void N##_destroy(N *t); \
+	container_size N##_size(const N *t); \
+	int N##_get(const N *t, const char *key, size_t len, V *value); \
+	V *N##_get_ref(N *t, const char *key, size_t len); \
+	int N##_set(N *t, const char *key, size_t len, V value); \
+	V *N##_upsert(N *t, const char *key, size_t len, int *inserted); \
+	int N##_delete(N *t, const char *key, size_t len); \
+	int N##_prefix_iterate(N *t, const char *prefix, size_t len, N##_visit fn, void *ctx); \
+	int N##_range(N *t, const char *lo, size_t lo_len, const char *hi, size_t hi_len, N##_visit fn, void *ctx)
+
+/*
+ * defines an adaptive radix tree mapping byte strings to V named N; each
+ * inner node branches on one byte of the keys and grows from 4 to 16, 48 and
+ * 256 children as needed; the bytes shared by all keys below a node are stored
+ * once in the node (path compression), and a leaf stores only the bytes of its
+ * key after the last branch, so keys with long common prefixes take little
+ * memory, and the keys are visited in order (by memcmp, shorter first)
+ */
+#define ART(V, N) \
+	struct N { container_size len; void *root; }; \
+	struct N##_leaf { V value; size_t len; }; \
+	struct N##_walker_ { \
+		unsigned char *buf; size_t len; size_t cap; \
+		const unsigned char *lo; size_t lo_len; \
+		const unsigned char *hi; size_t hi_len; \
+		const unsigned char *prefix; size_t prefix_len; \
+		N##_visit fn; void *ctx; int result; \
+	}; \
+	N *N##_new(void) \
+	{ \
+		N *t; \
+		t = CONTAINER_MALLOC(sizeof(struct N)); \
+		if (!t) return NULL; \
+		N##_init(t); \
+		return t; \
+	} \
+	void N##_free(N *t) \
+	{ \
+		N##_destroy(t); \
+		CONTAINER_FREE(t); \
+	} \
+	/* never fails, the tree allocates nothing until the first key is set */ \
+	int N##_init(N *t) \
+	{ \
+		t->len = 0; \
+		t->root = NULL; \
+		return 1; \
+	} \
+	void N##_free_(void *p) \
+	{ \
+		art_node *n; \
+		art_node48 *n48; \
+		art_node256 *n256; \
+		int i; \
+		if (!p) return; \
+		if (ART_IS_LEAF_(p)) { \
+			CONTAINER_FREE(ART_UNTAG_(p)); \
+			return; \
+		} \
+		n = p; \
+		CONTAINER_FREE(n->end); \
+		switch (n->type) { \
+		case ART_NODE4: \
+			for (i=0; i<n->count; ++i) N##_free_(((art_node4 *)n)->children[i]); \
+			break; \
+		case ART_NODE16: \
+			for (i=0; i<n->count; ++i) N##_free_(((art_node16 *)n)->children[i]); \
+			break; \
+		case ART_NODE48: \
+			n48 = (art_node48 *)n; \
+			for (i=0; i<48; ++i) N##_free_(n48->children[i]); \
+			break; \
+		default: \
+			n256 = (art_node256 *)n; \
+			for (i=0; i<256; ++i) N##_free_(n256->children[i]); \
+		} \
+		CONTAINER_FREE(n); \
+	} \
+	void N##_destroy(N *t) \
+	{ \
+		N##_free_(t->root); \
+	} \
+	container_size N##_size(const N *t) \
+	{ \
+		return t->len; \
+	} \
+	N##_leaf *N##_leaf_new_(const unsigned char *suffix, size_t len) \
+	{ \
+		N##_leaf *leaf; \
+		if (len > (size_t)-1 - sizeof(struct N##_leaf)) return NULL; \
+		leaf = CONTAINER_MALLOC(sizeof(struct N##_leaf) + len); \
+		if (!leaf) return NULL; \
+		memset(&leaf->value, 0, sizeof(V)); \
+		leaf->len = len; \
+		if (len) memcpy(ART_SUFFIX_(leaf), suffix, len); \
+		return leaf; \
+	} \
+	art_node *N##_node_new_(int type, const unsigned char *prefix, size_t prefix_len) \
+	{ \
+		art_node *n; \
+		if (prefix_len > (size_t)-1 - ART_NODE_SIZE_(type)) return NULL; \
+		n = CONTAINER_MALLOC(ART_NODE_SIZE_(type) + prefix_len); \
+		if (!n) return NULL; \
+		memset(n, 0, ART_NODE_SIZE_(type)); \
+		n->type = (unsigned char)type; \
+		n->prefix_len = prefix_len; \
+		if (prefix_len) memcpy(ART_PREFIX_(n), prefix, prefix_len); \
+		return n; \
+	} \
+	/* the slot of the child of n for byte c, NULL if there's none */ \
+	void **N##_child_(art_node *n, unsigned char c) \
+	{ \
+		unsigned char *keys; \
+		void **children; \
+		int i; \
+		switch (n->type) { \
+		case ART_NODE4: \
+		case ART_NODE16: \
+			keys = n->type == ART_NODE4 ? ((art_node4 *)n)->keys : ((art_node16 *)n)->keys; \
+			children = n->type == ART_NODE4 ? ((art_node4 *)n)->children : ((art_node16 *)n)->children; \
+			for (i=0; i<n->count && keys[i] <= c; ++i) { \
+				if (keys[i] == c) return &children[i]; \
+			} \
+			return NULL; \
+		case ART_NODE48: \
+			i = ((art_node48 *)n)->index[c]; \
+			return i ? &((art_node48 *)n)->children[i-1] : NULL; \
+		default: \
+			return ((art_node256 *)n)->children[c] ? &((art_node256 *)n)->children[c] : NULL; \
+		} \
+	} \
+	/* copies the children, end and prefix of n into a node of the given type and frees n */ \
+	art_node *N##_retype_(art_node *n, int type) \
+	{ \
+		art_node *m; \
+		unsigned char *keys, *to_keys; \
+		void **children, **to_children; \
+		int i, j; \
+		m = N##_node_new_(type, ART_PREFIX_(n), n->prefix_len); \
+		if (!m) return NULL; \
+		m->end = n->end; \
+		m->count = n->count; \
+		keys = n->type == ART_NODE4 ? ((art_node4 *)n)->keys : ((art_node16 *)n)->keys; \
+		children = n->type == ART_NODE4 ? ((art_node4 *)n)->children : ((art_node16 *)n)->children; \
+		to_keys = type == ART_NODE4 ? ((art_node4 *)m)->keys : ((art_node16 *)m)->keys; \
+		to_children = type == ART_NODE4 ? ((art_node4 *)m)->children : ((art_node16 *)m)->children; \
+		if (n->type <= ART_NODE16 && type <= ART_NODE16) { \
+			memcpy(to_keys, keys, n->count); \
+			memcpy(to_children, children, n->count * sizeof(void *)); \
+		} else if (n->type <= ART_NODE16) { \
+			for (i=0; i<n->count; ++i) { \
+				((art_node48 *)m)->index[keys[i]] = (unsigned char)(i + 1); \
+				((art_node48 *)m)->children[i] = children[i]; \
+			} \
+		} else if (n->type == ART_NODE48 && type == ART_NODE256) { \
+			for (i=0; i<256; ++i) { \
+				if (((art_node48 *)n)->index[i]) { \
+					((art_node256 *)m)->children[i] = ((art_node48 *)n)->children[((art_node48 *)n)->index[i] - 1]; \
+				} \
+			} \
+		} else if (n->type == ART_NODE48) { \
+			for (i=0, j=0; i<256; ++i) { \
+				if (((art_node48 *)n)->index[i]) { \
+					to_keys[j] = (unsigned char)i; \
+					to_children[j++] = ((art_node48 *)n)->children[((art_node48 *)n)->index[i] - 1]; \
+				} \
+			} \
+		} else { \
+			for (i=0, j=0; i<256; ++i) { \
+				if (((art_node256 *)n)->children[i]) { \
+					((art_node48 *)m)->index[i] = (unsigned char)(j + 1); \
+					((art_node48 *)m)->children[j++] = ((art_node256 *)n)->children[i]; \
+				} \
+			} \
+		} \
+		CONTAINER_FREE(n); \
+		return m; \
+	} \
+	/* adds child for byte c to the node at *ref, which has none, growing it if it's full */ \
+	int N##_add_child_(void **ref, unsigned char c, void *child) \
+	{ \
+		art_node *n; \
+		unsigned char *keys; \
+		void **children; \
+		int i; \
+		n = *ref; \
+		if (n->count == ART_NODE_CAP_(n->type)) { \
+			n = N##_retype_(n, n->type + 1); \
+			if (!n) return 0; \
+			*ref = n; \
+		} \
+		switch (n->type) { \
+		case ART_NODE4: \
+		case ART_NODE16: \
+			keys = n->type == ART_NODE4 ? ((art_node4 *)n)->keys : ((art_node16 *)n)->keys; \
+			children = n->type == ART_NODE4 ? ((art_node4 *)n)->children : ((art_node16 *)n)->children; \
+			for (i=n->count; i>0 && keys[i-1] > c; --i) { \
+				keys[i] = keys[i-1]; \
+				children[i] = children[i-1]; \
+			} \
+			keys[i] = c; \
+			children[i] = child; \
+			break; \
+		case ART_NODE48: \
+			for (i=0; ((art_node48 *)n)->children[i]; ++i); \
+			((art_node48 *)n)->index[c] = (unsigned char)(i + 1); \
+			((art_node48 *)n)->children[i] = child; \
+			break; \
+		default: \
+			((art_node256 *)n)->children[c] = child; \
+		} \
+		++n->count; \
+		return 1; \
+	} \
+	void N##_remove_child_(art_node *n, unsigned char c) \
+	{ \
+		unsigned char *keys; \
+		void **children; \
+		int i; \
+		switch (n->type) { \
+		case ART_NODE4: \
+		case ART_NODE16: \
+			keys = n->type == ART_NODE4 ? ((art_node4 *)n)->keys : ((art_node16 *)n)->keys; \
+			children = n->type == ART_NODE4 ? ((art_node4 *)n)->children : ((art_node16 *)n)->children; \
+			for (i=0; keys[i] != c; ++i); \
+			for (; i+1<n->count; ++i) { \
+				keys[i] = keys[i+1]; \
+				children[i] = children[i+1]; \
+			} \
+			break; \
+		case ART_NODE48: \
+			((art_node48 *)n)->children[((art_node48 *)n)->index[c] - 1] = NULL; \
+			((art_node48 *)n)->index[c] = 0; \
+			break; \
+		default: \
+			((art_node256 *)n)->children[c] = NULL; \
+		} \
+		--n->count; \
+	} \
+	/* \
+	 * after a removal from the node at *ref: replaces a node left with only \
+	 * its end leaf or only one child by that leaf or child, moving the prefix \
+	 * into it, or a node with few children by a smaller one; on malloc \
+	 * failure, the node stays as it is, which is still valid \
+	 */ \
+	void N##_collapse_(void **ref) \
+	{ \
+		art_node *n, *m; \
+		N##_leaf *leaf; \
+		void **slot; \
+		void *child; \
+		size_t len; \
+		int c; \
+		n = *ref; \
+		if (n->count == 0 && !n->end) { \
+			CONTAINER_FREE(n); \
+			*ref = NULL; \
+		} else if (n->count == 0) { \
+			leaf = CONTAINER_REALLOC(n->end, sizeof(struct N##_leaf) + n->prefix_len); \
+			if (!leaf) return; \
+			memcpy(ART_SUFFIX_(leaf), ART_PREFIX_(n), n->prefix_len); \
+			leaf->len = n->prefix_len; \
+			*ref = ART_TAG_(leaf); \
+			CONTAINER_FREE(n); \
+		} else if (n->count == 1 && !n->end) { \
+			for (c=0; !(slot = N##_child_(n, (unsigned char)c)); ++c); \
+			child = *slot; \
+			if (ART_IS_LEAF_(child)) { \
+				leaf = ART_UNTAG_(child); \
+				len = n->prefix_len + 1 + leaf->len; \
+				if (len < leaf->len || len > (size_t)-1 - sizeof(struct N##_leaf)) return; \
+				leaf = CONTAINER_REALLOC(leaf, sizeof(struct N##_leaf) + len); \
+				if (!leaf) return; \
+				memmove(ART_SUFFIX_(leaf) + n->prefix_len + 1, ART_SUFFIX_(leaf), leaf->len); \
+				memcpy(ART_SUFFIX_(leaf), ART_PREFIX_(n), n->prefix_len); \
+				ART_SUFFIX_(leaf)[n->prefix_len] = (unsigned char)c; \
+				leaf->len = len; \
+				*ref = ART_TAG_(leaf); \
+			} else { \
+				m = child; \
+				len = n->prefix_len + 1 + m->prefix_len; \
+				if (len < m->prefix_len || len > (size_t)-1 - ART_NODE_SIZE_(m->type)) return; \
+				m = CONTAINER_REALLOC(m, ART_NODE_SIZE_(m->type) + len); \
+				if (!m) return; \
+				memmove(ART_PREFIX_(m) + n->prefix_len + 1, ART_PREFIX_(m), m->prefix_len); \
+				memcpy(ART_PREFIX_(m), ART_PREFIX_(n), n->prefix_len); \
+				ART_PREFIX_(m)[n->prefix_len] = (unsigned char)c; \
+				m->prefix_len = len; \
+				*ref = m; \
+			} \
+			CONTAINER_FREE(n); \
+		} else if ((n->type == ART_NODE16 && n->count <= ART_SHRINK16) \
+				|| (n->type == ART_NODE48 && n->count <= ART_SHRINK48) \
+				|| (n->type == ART_NODE256 && n->count <= ART_SHRINK256)) { \
+			m = N##_retype_(n, n->type - 1); \
+			if (m) *ref = m; \
+		} \
+	} \
+	N##_leaf *N##_find_(const N *t, const unsigned char *key, size_t len) \
+	{ \
+		void *p; \
+		void **slot; \
+		art_node *n; \
+		N##_leaf *leaf; \
+		size_t d; \
+		p = t->root; \
+		d = 0; \
+		while (p) { \
+			if (ART_IS_LEAF_(p)) { \
+				leaf = ART_UNTAG_(p); \
+				if (leaf->len != len - d || memcmp(ART_SUFFIX_(leaf), key + d, leaf->len)) return NULL; \
+				return leaf; \
+			} \
+			n = p; \
+			if (n->prefix_len > len - d || memcmp(ART_PREFIX_(n), key + d, n->prefix_len)) return NULL; \
+			d += n->prefix_len; \
+			if (d == len) return n->end; \
+			slot = N##_child_(n, key[d]); \
+			if (!slot) return NULL; \
+			p = *slot; \
+			++d; \
+		} \
+		return NULL; \
+	} \
+	int N##_get(const N *t, const char *key, size_t len, V *value) \
+	{ \
+		N##_leaf *leaf; \
+		leaf = N##_find_(t, (const unsigned char *)key, len); \
+		if (!leaf) return 0; \
+		if (value) *value = leaf->value; \
+		return 1; \
+	} \
+	V *N##_get_ref(N *t, const char *key, size_t len) \
+	{ \
+		N##_leaf *leaf; \
+		leaf = N##_find_(t, (const unsigned char *)key, len); \
+		return leaf ? &leaf->value : NULL; \
+	} \
+	/* \
+	 * replaces the leaf or node at *ref, whose first p bytes (suffix or \
+	 * prefix) match the key at depth d, by a node4 with these p bytes as its \
+	 * prefix, the old leaf or node and a new leaf for the key as its children \
+	 */ \
+	N##_leaf *N##_split_(void **ref, const unsigned char *key, size_t len, size_t d, size_t p) \
+	{ \
+		art_node *split; \
+		N##_leaf *leaf; \
+		unsigned char *bytes; \
+		size_t *bytes_len; \
+		void *old; \
+		old = *ref; \
+		bytes = ART_IS_LEAF_(old) ? ART_SUFFIX_((N##_leaf *)ART_UNTAG_(old)) : ART_PREFIX_((art_node *)old); \
+		bytes_len = ART_IS_LEAF_(old) ? &((N##_leaf *)ART_UNTAG_(old))->len : &((art_node *)old)->prefix_len; \
+		split = N##_node_new_(ART_NODE4, bytes, p); \
+		if (!split) return NULL; \
+		leaf = d + p == len ? N##_leaf_new_(NULL, 0) : N##_leaf_new_(key + d + p + 1, len - d - p - 1); \
+		if (!leaf) { \
+			CONTAINER_FREE(split); \
+			return NULL; \
+		} \
+		*ref = split; \
+		/* the old leaf or node keeps the bytes after the branch */ \
+		if (*bytes_len == p) { \
+			split->end = ART_UNTAG_(old); \
+			*bytes_len = 0; \
+		} else { \
+			N##_add_child_(ref, bytes[p], old); \
+			memmove(bytes, bytes + p + 1, *bytes_len - p - 1); \
+			*bytes_len -= p + 1; \
+		} \
+		if (d + p == len) { \
+			split->end = leaf; \
+		} else { \
+			N##_add_child_(ref, key[d+p], ART_TAG_(leaf)); \
+		} \
+		return leaf; \
+	} \
+	/* returns the leaf of key, adding it if it isn't in the tree, NULL on malloc failure */ \
+	N##_leaf *N##_insert_(N *t, const unsigned char *key, size_t len, int *inserted) \
+	{ \
+		void **ref, **slot; \
+		art_node *n; \
+		N##_leaf *leaf; \
+		size_t d, p, max; \
+		*inserted = 1; \
+		ref = &t->root; \
+		d = 0; \
+		for (;;) { \
+			if (!*ref) { \
+				leaf = N##_leaf_new_(key + d, len - d); \
+				if (leaf) *ref = ART_TAG_(leaf); \
+				return leaf; \
+			} \
+			if (ART_IS_LEAF_(*ref)) { \
+				leaf = ART_UNTAG_(*ref); \
+				max = leaf->len < len - d ? leaf->len : len - d; \
+				for (p=0; p<max && ART_SUFFIX_(leaf)[p] == key[d+p]; ++p); \
+				if (p == leaf->len && p == len - d) { \
+					*inserted = 0; \
+					return leaf; \
+				} \
+				return N##_split_(ref, key, len, d, p); \
+			} \
+			n = *ref; \
+			max = n->prefix_len < len - d ? n->prefix_len : len - d; \
+			for (p=0; p<max && ART_PREFIX_(n)[p] == key[d+p]; ++p); \
+			if (p < n->prefix_len) return N##_split_(ref, key, len, d, p); \
+			d += n->prefix_len; \
+			if (d == len) { \
+				if (n->end) { \
+					*inserted = 0; \
+					return n->end; \
+				} \
+				n->end = N##_leaf_new_(NULL, 0); \
+				return n->end; \
+			} \
+			slot = N##_child_(n, key[d]); \
+			if (!slot) { \
+				leaf = N##_leaf_new_(key + d + 1, len - d - 1); \
+				if (leaf && !N##_add_child_(ref, key[d], ART_TAG_(leaf))) { \
+					CONTAINER_FREE(leaf); \
+					return NULL; \
+				} \
+				return leaf; \
+			} \
+			ref = slot; \
+			++d; \
+		} \
+	} \
+	V *N##_upsert(N *t, const char *key, size_t len, int *inserted) \
+	{ \
+		N##_leaf *leaf; \
+		int added; \
+		leaf = N##_insert_(t, (const unsigned char *)key, len, &added); \
+		if (!leaf) return NULL; \
+		t->len += added; \
+		if (inserted) *inserted = added; \
+		return &leaf->value; \
+	} \
+	int N##_set(N *t, const char *key, size_t len, V value) \
+	{ \
+		V *ref; \
+		ref = N##_upsert(t, key, len, NULL); \
+		if (!ref) return 0; \
+		*ref = value; \
+		return 1; \
+	} \
+	/* \
+	 * removes the key from the leaf or node at *ref, whose bytes start at \
+	 * depth d of the key, and collapses the nodes it leaves with fewer \
+	 * children on the way back; sets *ref to NULL if nothing is left; returns \
+	 * 1 if the key was removed \
+	 */ \
+	int N##_delete_(void **ref, const unsigned char *key, size_t len, size_t d) \
+	{ \
+		void **slot; \
+		art_node *n; \
+		N##_leaf *leaf; \
+		if (ART_IS_LEAF_(*ref)) { \
+			leaf = ART_UNTAG_(*ref); \
+			if (leaf->len != len - d || memcmp(ART_SUFFIX_(leaf), key + d, leaf->len)) return 0; \
+			CONTAINER_FREE(leaf); \
+			*ref = NULL; \
+			return 1; \
+		} \
+		n = *ref; \
+		if (n->prefix_len > len - d || memcmp(ART_PREFIX_(n), key + d, n->prefix_len)) return 0; \
+		d += n->prefix_len; \
+		if (d == len) { \
+			if (!n->end) return 0; \
+			CONTAINER_FREE(n->end); \
+			n->end = NULL; \
+		} else { \
+			slot = N##_child_(n, key[d]); \
+			if (!slot || !N##_delete_(slot, key, len, d + 1)) return 0; \
+			if (*slot) return 1; \
+			/* the child is gone, a leaf or a node a failed collapse left with one child */ \
+			N##_remove_child_(n, key[d]); \
+		} \
+		N##_collapse_(ref); \
+		return 1; \
+	} \
+	int N##_delete(N *t, const char *key, size_t len) \
+	{ \
+		if (!t->root || !N##_delete_(&t->root, (const unsigned char *)key, len, 0)) return 0; \
+		--t->len; \
+		return 1; \
+	} \
+	/* \
+	 * compares the bytes from start added to the key in the walk buffer with \
+	 * the bounds still equal to it (flagged in *eq, 1 lo, 2 hi, 4 prefix); \
+	 * returns -1 if the keys under it are before the range, 1 if they're after \
+	 * it, 0 if they may be in it, and clears the flags of decided bounds \
+	 */ \
+	int N##_bounds_(N##_walker_ *w, size_t start, int *eq) \
+	{ \
+		size_t end; \
+		int c; \
+		if (*eq & 1) { \
+			end = w->len < w->lo_len ? w->len : w->lo_len; \
+			c = start < end ? memcmp(w->buf + start, w->lo + start, end - start) : 0; \
+			if (c < 0) return -1; \
+			if (c > 0 || w->len >= w->lo_len) *eq &= ~1; \
+		} \
+		if (*eq & 2) { \
+			end = w->len < w->hi_len ? w->len : w->hi_len; \
+			c = start < end ? memcmp(w->buf + start, w->hi + start, end - start) : 0; \
+			if (c > 0 || (c == 0 && w->len >= w->hi_len)) return 1; \
+			if (c < 0) *eq &= ~2; \
+		} \
+		if (*eq & 4) { \
+			end = w->len < w->prefix_len ? w->len : w->prefix_len; \
+			c = start < end ? memcmp(w->buf + start, w->prefix + start, end - start) : 0; \
+			if (c) return c < 0 ? -1 : 1; \
+			if (w->len >= w->prefix_len) *eq &= ~4; \
+		} \
+		return 0; \
+	} \
+	/* makes room for extra more bytes and the null terminator in the walk buffer */ \
+	int N##_walk_reserve_(N##_walker_ *w, size_t extra) \
+	{ \
+		unsigned char *buf; \
+		size_t cap; \
+		if (w->len + extra < w->cap) return 1; \
+		cap = w->len + extra + 1 > 2 * w->cap ? w->len + extra + 1 : 2 * w->cap; \
+		buf = CONTAINER_REALLOC(w->buf, cap); \
+		if (!buf) return 0; \
+		w->buf = buf; \
+		w->cap = cap; \
+		return 1; \
+	} \
+	/* calls fn with the key in the buffer if it isn't before lo or a part of prefix */ \
+	int N##_visit_(N##_walker_ *w, N##_leaf *leaf, int eq) \
+	{ \
+		if (eq & 5) return 0; \
+		w->buf[w->len] = 0; \
+		w->result = w->fn((const char *)w->buf, w->len, &leaf->value, w->ctx); \
+		return w->result != 0; \
+	} \
+	/* \
+	 * visits the leaves under p in order, start is the length of the key in \
+	 * the buffer before the byte leading to p; returns nonzero to stop \
+	 */ \
+	int N##_walk_(N##_walker_ *w, void *p, size_t start, int eq) \
+	{ \
+		art_node *n; \
+		N##_leaf *leaf; \
+		unsigned char *keys; \
+		void **children, **slot; \
+		size_t len; \
+		int r, i, c, from, to; \
+		if (ART_IS_LEAF_(p)) { \
+			leaf = ART_UNTAG_(p); \
+			if (!N##_walk_reserve_(w, leaf->len)) return w->result = -1; \
+			memcpy(w->buf + w->len, ART_SUFFIX_(leaf), leaf->len); \
+			len = w->len; \
+			w->len += leaf->len; \
+			r = N##_bounds_(w, start, &eq); \
+			r = r > 0 || (r == 0 && N##_visit_(w, leaf, eq)); \
+			w->len = len; \
+			return r; \
+		} \
+		n = p; \
+		if (!N##_walk_reserve_(w, n->prefix_len + 1)) return w->result = -1; \
+		memcpy(w->buf + w->len, ART_PREFIX_(n), n->prefix_len); \
+		len = w->len; \
+		w->len += n->prefix_len; \
+		r = N##_bounds_(w, start, &eq); \
+		if (r == 0 && n->end) r = N##_visit_(w, n->end, eq); \
+		if (r != 0) { \
+			w->len = len; \
+			return r > 0; \
+		} \
+		/* only the children from the byte of lo or prefix can be in the range */ \
+		from = eq & 1 ? w->lo[w->len] : eq & 4 ? w->prefix[w->len] : 0; \
+		to = eq & 4 ? from : 255; \
+		if (n->type <= ART_NODE16) { \
+			keys = n->type == ART_NODE4 ? ((art_node4 *)n)->keys : ((art_node16 *)n)->keys; \
+			children = n->type == ART_NODE4 ? ((art_node4 *)n)->children : ((art_node16 *)n)->children; \
+			for (i=0; i<n->count && keys[i] <= to && !r; ++i) { \
+				if (keys[i] < from) continue; \
+				w->buf[w->len] = keys[i]; \
+				++w->len; \
+				r = N##_walk_(w, children[i], w->len - 1, eq); \
+				w->len = len + n->prefix_len; \
+			} \
+		} else { \
+			for (c=from; c<=to && !r; ++c) { \
+				slot = N##_child_(n, (unsigned char)c); \
+				if (!slot) continue; \
+				w->buf[w->len] = (unsigned char)c; \
+				++w->len; \
+				r = N##_walk_(w, *slot, w->len - 1, eq); \
+				w->len = len + n->prefix_len; \
+			} \
+		} \
+		w->len = len; \
+		return r; \
+	} \
+	int N##_scan_(N *t, N##_walker_ *w) \
+	{ \
+		w->buf = NULL; \
+		w->len = 0; \
+		w->cap = 0; \
+		w->result = 0; \
+		if (t->root && N##_walk_reserve_(w, 64)) { \
+			N##_walk_(w, t->root, 0, (w->lo ? 1 : 0) | (w->hi ? 2 : 0) | (w->prefix ? 4 : 0)); \
+		} else if (t->root) { \
+			w->result = -1; \
+		} \
+		CONTAINER_FREE(w->buf); \
+		return w->result; \
+	} \
+	/* \
+	 * calls fn with each key starting with the len bytes of prefix in order, \
+	 * its length and a pointer to its value; the key is null-terminated and \
+	 * valid during the call; returns the first nonzero value returned by fn, \
+	 * which stops the walk, 0 after all keys or -1 on malloc failure \
+	 */ \
+	int N##_prefix_iterate(N *t, const char *prefix, size_t len, N##_visit fn, void *ctx) \
+	{ \
+		N##_walker_ w; \
+		w.lo = NULL; \
+		w.lo_len = 0; \
+		w.hi = NULL; \
+		w.hi_len = 0; \
+		w.prefix = (const unsigned char *)prefix; \
+		w.prefix_len = len; \
+		w.fn = fn; \
+		w.ctx = ctx; \
+		return N##_scan_(t, &w); \
+	} \
+	/* same as N##_prefix_iterate for the keys from lo (unless NULL) up to, but not including, hi (unless NULL) */ \
+	int N##_range(N *t, const char *lo, size_t lo_len, const char *hi, size_t hi_len, N##_visit fn, void *ctx) \
+	{ \
+		N##_walker_ w; \
+		w.lo = (const unsigned char *)lo; \
+		w.lo_len = lo_len; \
+		w.hi = (const unsigned char *)hi; \
+		w.hi_len = hi_len; \
+		w.prefix = NULL; \
+		w.prefix_len = 0; \
+		w.fn = fn; \
+		w.ctx = ctx; \
+		return N##_scan_(t, &w); \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+#endif /* ifndef ART_H_INCLUDED */
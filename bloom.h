@@ -0,0 +1,161 @@
+/* bloom.h: a CPP-based template implementation of blocked bloom filter */
+
+#ifndef BLOOM_H_INCLUDED
+#define BLOOM_H_INCLUDED 1
+
+#include <stdlib.h>
+#include <string.h>
+#include "container.h"
+
+#define BLOOM_BITS_PER_KEY 10 /* minimum bits per key a filter is sized for, ~1% false positives */
+#define BLOOM_BATCH 16 /* keys hashed and prefetched at once by N##_build */
+
+#ifdef __GNUC__
+#define BLOOM_PREFETCH(p) __builtin_prefetch(p, 1)
+#else
+#define BLOOM_PREFETCH(p) ((void)0)
+#endif
+
+/* odd multipliers picking the bit of a key in each word of its block */
+#define BLOOM_SALT_ { \
+	0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, \
+	0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U \
+}
+
+#define BLOOM_PROTO(K, N) \
+	typedef struct N N; \
+	N *N##_new(container_size keys); \
+	void N##_free(N *f); \
+	int N##_init(N *f, container_size keys); \
+	void N##_destroy(N *f); \
+	void N##_clear(N *f); \
+	void N##_add(N *f, K key); \
+	int N##_contains(const N *f, K key); \
+	void N##_add_hashed(N *f, container_hash hash); \
+	int N##_contains_hashed(const N *f, container_hash hash); \
+	int N##_build(N *f, K const *keys, container_size len)
+
+/*
+ * defines a bloom filter of K keys named N; H is the same as in HMAP; the
+ * filter is an array of 32-byte blocks, each key sets one bit in each of the
+ * 8 words of one block, so adding or checking a key touches one cache line
+ */
+#define BLOOM(K, N, H) \
+	struct N { container_size mask; uint32_t *blocks; void *mem; }; \
+	container_hash N##_hash(K _bloom_key) \
+	{ \
+		return H(_bloom_key); \
+	} \
+	N *N##_new(container_size keys) \
+	{ \
+		N *f; \
+		f = CONTAINER_MALLOC(sizeof(struct N)); \
+		if (!f) return NULL; \
+		if (!N##_init(f, keys)) { \
+			CONTAINER_FREE(f); \
+			return NULL; \
+		} \
+		return f; \
+	} \
+	void N##_free(N *f) \
+	{ \
+		N##_destroy(f); \
+		CONTAINER_FREE(f); \
+	} \
+	/* sizes the filter for keys keys, the number of blocks is a power of two */ \
+	int N##_init(N *f, container_size keys) \
+	{ \
+		container_size blocks, need; \
+		need = keys / (256 / BLOOM_BITS_PER_KEY > 0 ? 256 / BLOOM_BITS_PER_KEY : 1) + 1; \
+		for (blocks=1; blocks<need; blocks*=2) { \
+			if (blocks > CONTAINER_SIZE_MAX/2) return 0; \
+		} \
+		if (CONTAINER_OVERFLOWS(blocks, 32) || blocks * (size_t)32 > (size_t)-1 - 31) return 0; \
+		f->mem = CONTAINER_MALLOC(blocks * (size_t)32 + 31); \
+		if (!f->mem) return 0; \
+		f->blocks = (uint32_t *)(((uintptr_t)f->mem + 31) & ~(uintptr_t)31); \
+		f->mask = blocks - 1; \
+		N##_clear(f); \
+		return 1; \
+	} \
+	void N##_destroy(N *f) \
+	{ \
+		CONTAINER_FREE(f->mem); \
+	} \
+	void N##_clear(N *f) \
+	{ \
+		memset(f->blocks, 0, (f->mask + 1) * (size_t)32); \
+	} \
+	/* the block is picked by the low bits of hash, remix them for the bits in it */ \
+	uint32_t N##_remix_(container_hash hash) \
+	{ \
+		uint32_t x; \
+		x = (uint32_t)hash; \
+		x ^= x >> 16; \
+		x *= 0x7feb352dU; \
+		x ^= x >> 15; \
+		x *= 0x846ca68bU; \
+		x ^= x >> 16; \
+		return x; \
+	} \
+	void N##_add_hashed(N *f, container_hash hash) \
+	{ \
+		static const uint32_t salt[8] = BLOOM_SALT_; \
+		uint32_t *block, x; \
+		int i; \
+		block = &f->blocks[(hash & f->mask) * 8]; \
+		x = N##_remix_(hash); \
+		for (i=0; i<8; ++i) { \
+			block[i] |= (uint32_t)1 << ((x * salt[i]) >> 27); \
+		} \
+	} \
+	/* returns 0 if the key with hash was never added, 1 if it probably was */ \
+	int N##_contains_hashed(const N *f, container_hash hash) \
+	{ \
+		static const uint32_t salt[8] = BLOOM_SALT_; \
+		const uint32_t *block; \
+		uint32_t x, missing; \
+		int i; \
+		block = &f->blocks[(hash & f->mask) * 8]; \
+		x = N##_remix_(hash); \
+		missing = 0; \
+		for (i=0; i<8; ++i) { \
+			missing |= ((uint32_t)1 << ((x * salt[i]) >> 27)) & ~block[i]; \
+		} \
+		return !missing; \
+	} \
+	void N##_add(N *f, K key) \
+	{ \
+		N##_add_hashed(f, N##_hash(key)); \
+	} \
+	int N##_contains(const N *f, K key) \
+	{ \
+		return N##_contains_hashed(f, N##_hash(key)); \
+	} \
+	/* \
+	 * replaces the filter with one sized for and containing the len keys, \
+	 * hashing them in batches and prefetching their blocks before setting bits \
+	 */ \
+	int N##_build(N *f, K const *keys, container_size len) \
+	{ \
+		N tmp; \
+		container_hash hashes[BLOOM_BATCH]; \
+		container_size i, j, n; \
+		if (!N##_init(&tmp, len)) return 0; \
+		N##_destroy(f); \
+		*f = tmp; \
+		for (i=0; i<len; i+=n) { \
+			n = len - i < BLOOM_BATCH ? len - i : BLOOM_BATCH; \
+			for (j=0; j<n; ++j) { \
+				hashes[j] = N##_hash(keys[i+j]); \
+				BLOOM_PREFETCH(&f->blocks[(hashes[j] & f->mask) * 8]); \
+			} \
+			for (j=0; j<n; ++j) { \
+				N##_add_hashed(f, hashes[j]); \
+			} \
+		} \
+		return 1; \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+#endif /* ifndef BLOOM_H_INCLUDED */
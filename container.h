@@ -0,0 +1,61 @@
+/* container.h: the size and hash types and the allocator shared by the container templates */
+
+#ifndef CONTAINER_H_INCLUDED
+#define CONTAINER_H_INCLUDED 1
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * container_size is the type of all lengths, capacities, positions and index
+ * iterators, int by default; define CONTAINER_64BIT before including any of
+ * the headers to use ptrdiff_t instead, so containers can grow past INT_MAX
+ * elements on 64-bit platforms; it's signed because -1 is a valid position
+ */
+#ifdef CONTAINER_64BIT
+typedef ptrdiff_t container_size;
+#define CONTAINER_SIZE_MAX PTRDIFF_MAX
+#else
+typedef int container_size;
+#define CONTAINER_SIZE_MAX INT_MAX
+#endif
+
+/*
+ * container_hash is the type of the hashes stored in hashmap entries and
+ * returned by their hash functions, uint32_t by default; define CONTAINER_HASH64
+ * to use uint64_t, which keeps collisions rare in maps with billions of entries
+ */
+#ifdef CONTAINER_HASH64
+typedef uint64_t container_hash;
+#else
+typedef uint32_t container_hash;
+#endif
+
+/*
+ * the allocator of all containers, malloc, realloc and free by default; define
+ * these before including any of the headers to allocate from somewhere else,
+ * e.g. the scoped arenas of unique.h; like the macros above, all translation
+ * units sharing containers must agree on them; stdlib.h is included by the
+ * headers which use the defaults
+ */
+#ifndef CONTAINER_MALLOC
+#define CONTAINER_MALLOC(size) malloc(size)
+#endif
+#ifndef CONTAINER_REALLOC
+#define CONTAINER_REALLOC(p, size) realloc(p, size)
+#endif
+#ifndef CONTAINER_FREE
+#define CONTAINER_FREE(p) free(p)
+#endif
+
+/* nonzero if an array of n (>= 0) elements of the given size doesn't fit in a size_t */
+#define CONTAINER_OVERFLOWS(n, size) ((size_t)(n) > (size_t)-1 / (size))
+
+/* the capacity 1.5 times cap (rounded up) and at least 1, CONTAINER_SIZE_MAX if that doesn't fit */
+#define CONTAINER_GROW(cap) ((cap) < 1 ? 1 : (cap) < CONTAINER_SIZE_MAX/3*2 ? (cap) + ((cap)+1)/2 : CONTAINER_SIZE_MAX)
+
+/* a pointer to the struct of the given type whose field member is at ptr */
+#define CONTAINER_OF(ptr, type, member) ((type *)(void *)((char *)(ptr) - offsetof(type, member)))
+
+#endif /* ifndef CONTAINER_H_INCLUDED */
@@ -0,0 +1,219 @@
+/* dlist.h: a CPP-based template implementation of doubly-linked list */
+
+#ifndef DLIST_H_INCLUDED
+#define DLIST_H_INCLUDED 1
+
+#include <stdlib.h>
+#include "container.h"
+
+#define DLIST_PROTO(T, N) \
+	typedef struct N##_node N##_node; \
+	typedef struct N N; \
+	typedef N##_node *N##_iterator; \
+	N *N##_new(void); \
+	void N##_free(N *s); \
+	int N##_init(N *s); \
+	void N##_destroy(N *s); \
+	N##_node *N##_node_new(T item); \
+	container_size N##_size(const N *s); \
+	int N##_insert(N *s, T item, container_size pos); \
+	T N##_pop(N *s, container_size pos); \
+	T N##_get(const N *s, container_size pos); \
+	void N##_set(N *s, T item, container_size pos); \
+	N##_iterator N##_iterate(const N *s); \
+	int N##_next(const N *s, N##_iterator *iter); \
+	int N##_prev(const N *s, N##_iterator *iter); \
+	T N##_get_at(const N *s, N##_iterator iter); \
+	void N##_set_at(N *s, T item, N##_iterator iter); \
+	int N##_insert_at(N *s, T item, N##_iterator iter); \
+	T N##_pop_at(N *s, N##_iterator iter); \
+	void N##_link(N *s, N##_node *node, N##_iterator iter); \
+	void N##_unlink(N *s, N##_node *node); \
+	void N##_splice(N *s, N##_iterator iter, N *other); \
+	void N##_splice_range(N *s, N##_iterator iter, N *other, N##_node *first, N##_node *last, container_size count)
+
+/* defines functions for a doubly-linked list with elements of type T named N */
+#define DLIST(T, N) \
+	DLIST_STRUCT(T, N); \
+	DLIST_FUNCTIONS(T, N)
+
+/*
+ * DLIST split in two: DLIST_STRUCT defines the structs, so they can go in a
+ * header after DLIST_PROTO for a list embedded by value in another struct, and
+ * DLIST_FUNCTIONS then defines the functions in one .c file
+ */
+#define DLIST_STRUCT(T, N) \
+	struct N##_node { T value; N##_node *prev; N##_node *next; }; \
+	struct N { container_size len; N##_node *first; N##_node *last; }
+
+#define DLIST_FUNCTIONS(T, N) \
+	N *N##_new(void) \
+	{ \
+		N *s; \
+		s = CONTAINER_MALLOC(sizeof(struct N)); \
+		if (!s) return NULL; \
+		N##_init(s); \
+		return s; \
+	} \
+	void N##_free(N *s) \
+	{ \
+		N##_destroy(s); \
+		CONTAINER_FREE(s); \
+	} \
+	int N##_init(N *s) \
+	{ \
+		s->len = 0; \
+		s->first = NULL; \
+		s->last = NULL; \
+		return 1; \
+	} \
+	void N##_destroy(N *s) \
+	{ \
+		N##_node *p, *temp; \
+		for (p=s->first; p; ) { \
+			temp = p; \
+			p = p->next; \
+			CONTAINER_FREE(temp); \
+		} \
+	} \
+	N##_node *N##_node_new(T item) \
+	{ \
+		N##_node *p; \
+		p = CONTAINER_MALLOC(sizeof(struct N##_node)); \
+		if (!p) return NULL; \
+		p->value = item; \
+		p->prev = NULL; \
+		p->next = NULL; \
+		return p; \
+	} \
+	container_size N##_size(const N *s) \
+	{ \
+		return s->len; \
+	} \
+	/* returns the node at pos, walking from the nearer end of the list */ \
+	N##_node *N##_at_(const N *s, container_size pos) \
+	{ \
+		N##_node *p; \
+		container_size i; \
+		if (pos < 0) return s->last; \
+		if (pos < s->len/2) { \
+			for (p=s->first, i=0; i<pos; ++i) p=p->next; \
+		} else { \
+			for (p=s->last, i=s->len-1; i>pos; --i) p=p->prev; \
+		} \
+		return p; \
+	} \
+	/* links node before iter, or to the tail if iter is NULL */ \
+	void N##_link(N *s, N##_node *node, N##_iterator iter) \
+	{ \
+		node->next = iter; \
+		node->prev = iter ? iter->prev : s->last; \
+		if (node->prev) node->prev->next = node; \
+		else s->first = node; \
+		if (iter) iter->prev = node; \
+		else s->last = node; \
+		++s->len; \
+	} \
+	/* removes node from the list without freeing it */ \
+	void N##_unlink(N *s, N##_node *node) \
+	{ \
+		if (node->prev) node->prev->next = node->next; \
+		else s->first = node->next; \
+		if (node->next) node->next->prev = node->prev; \
+		else s->last = node->prev; \
+		node->prev = node->next = NULL; \
+		--s->len; \
+	} \
+	int N##_insert(N *s, T item, container_size pos) \
+	{ \
+		N##_node *newp; \
+		if (pos > s->len) return 0; \
+		newp = N##_node_new(item); \
+		if (!newp) return 0; \
+		N##_link(s, newp, pos < 0 || pos == s->len ? NULL : N##_at_(s, pos)); \
+		return 1; \
+	} \
+	T N##_pop(N *s, container_size pos) \
+	{ \
+		return N##_pop_at(s, N##_at_(s, pos)); \
+	} \
+	T N##_get(const N *s, container_size pos) \
+	{ \
+		return N##_at_(s, pos)->value; \
+	} \
+	void N##_set(N *s, T item, container_size pos) \
+	{ \
+		N##_at_(s, pos)->value = item; \
+	} \
+	N##_iterator N##_iterate(const N *s) \
+	{ \
+		return NULL; \
+	} \
+	/* moves iter to the next node, from a new iterator to the first one */ \
+	int N##_next(const N *s, N##_iterator *iter) \
+	{ \
+		*iter = *iter ? (*iter)->next : s->first; \
+		return *iter != NULL; \
+	} \
+	/* moves iter to the previous node, from a new iterator to the last one */ \
+	int N##_prev(const N *s, N##_iterator *iter) \
+	{ \
+		*iter = *iter ? (*iter)->prev : s->last; \
+		return *iter != NULL; \
+	} \
+	T N##_get_at(const N *s, N##_iterator iter) \
+	{ \
+		return iter->value; \
+	} \
+	void N##_set_at(N *s, T item, N##_iterator iter) \
+	{ \
+		iter->value = item; \
+	} \
+	int N##_insert_at(N *s, T item, N##_iterator iter) \
+	{ \
+		N##_node *newp; \
+		newp = N##_node_new(item); \
+		if (!newp) return 0; \
+		N##_link(s, newp, iter); \
+		return 1; \
+	} \
+	T N##_pop_at(N *s, N##_iterator iter) \
+	{ \
+		T val; \
+		N##_unlink(s, iter); \
+		val = iter->value; \
+		CONTAINER_FREE(iter); \
+		return val; \
+	} \
+	/* moves all nodes of other before iter (to the tail if NULL) */ \
+	void N##_splice(N *s, N##_iterator iter, N *other) \
+	{ \
+		if (!other->first) return; \
+		N##_splice_range(s, iter, other, other->first, other->last, other->len); \
+	} \
+	/* \
+	 * moves the nodes from first to last (inclusive) of other before iter (to \
+	 * the tail if NULL); count is their number, -1 to count them in O(count) \
+	 */ \
+	void N##_splice_range(N *s, N##_iterator iter, N *other, N##_node *first, N##_node *last, container_size count) \
+	{ \
+		N##_node *p; \
+		if (count < 0) { \
+			for (p=first, count=1; p != last; p=p->next) ++count; \
+		} \
+		if (first->prev) first->prev->next = last->next; \
+		else other->first = last->next; \
+		if (last->next) last->next->prev = first->prev; \
+		else other->last = first->prev; \
+		other->len -= count; \
+		last->next = iter; \
+		first->prev = iter ? iter->prev : s->last; \
+		if (first->prev) first->prev->next = first; \
+		else s->first = first; \
+		if (iter) iter->prev = last; \
+		else s->last = last; \
+		s->len += count; \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+#endif /* ifndef DLIST_H_INCLUDED */
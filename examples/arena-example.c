@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the containers allocate from the current scoped arena, or from malloc outside of one */
+#define CONTAINER_MALLOC(size)     scoped_arena_malloc( size )
+#define CONTAINER_REALLOC(p, size) scoped_arena_realloc( p, size )
+#define CONTAINER_FREE(p)          scoped_arena_free( p )
+
+#include "../unique.h"
+#include "../alist.h"
+#include "../hmap.h"
+#include "../tree.h"
+
+#define CMP(a, b) strcmp( a, b )
+
+uint32_t djb2( const char *str );
+
+ALIST_PROTO( const char *, words );
+ALIST( const char *, words );
+HMAP_PROTO( const char *, int, counts );
+HMAP( const char *, int, counts, CMP, djb2 );
+TREE_PROTO( const char *, tree );
+TREE( const char *, tree );
+
+uint32_t djb2( const char *str ){
+	uint32_t hash = 5381;
+
+	while ( *str ){
+		hash = hash * 33 + (unsigned char)*str++;
+	}
+
+	return hash;
+}
+
+/* Handles one request with temporary containers, none of which is freed */
+void handle( counts *totals, const char *request ){
+	scoped_arena(arena, 4096);
+	char *copy = scoped_arena_alloc( &arena, strlen( request ) + 1 );
+	words *w = words_new();
+	counts *c = counts_new();
+	char *word;
+
+	if ( !copy || !w || !c ){
+		return;
+	}
+
+	strcpy( copy, request );
+	for ( word = strtok( copy, " " ); word; word = strtok( NULL, " " )){
+		words_insert( w, word, -1 );
+		++*counts_upsert( c, word, NULL );
+	}
+
+	{
+		/* the tree is only needed here, rewinding the arena drops it */
+		scoped_checkpoint(mark, &arena);
+		tree *t = tree_construct( words_get( w, 0 ), NULL, tree_new( words_get( w, -1 )));
+
+		printf( "%d words, %d distinct, tree of %u nodes\n",
+				(int)words_size( w ), (int)counts_size( c ), (unsigned)tree_size( t ));
+	}
+
+	{
+		/* totals outlives the arena, so what it allocates has to come from
+		 * malloc, and its keys mustn't point into the arena either */
+		scoped_arena_use(heap, NULL);
+
+		counts_set( totals, request, (int)words_size( w ));
+	}
+}
+
+int main( int argc, char *argv[] ){
+	static const char *requests[] = {
+		"get index html",
+		"get style css",
+		"post form get index",
+	};
+	counts *totals = counts_new();
+	int i;
+
+	if ( !totals ){
+		return 1;
+	}
+
+	for ( i = 0; i < 3; i++ ){
+		handle( totals, requests[i] );
+	}
+
+	for ( i = 0; i < 3; i++ ){
+		printf( "%s: %d words\n", requests[i], counts_get( totals, requests[i] ));
+	}
+
+	counts_free( totals );
+
+	return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * Compares an adaptive radix tree generated by ART with an HMAP of string keys
+ * (strcmp and djb2, like in map-example.c) on URL-like and path-like keys,
+ * which share long prefixes: the time of inserts and of lookups of keys which
+ * are and aren't in the containers, and the bytes allocated per key, which
+ * include the copies of the keys the map points to.
+ *
+ * gcc -O2 -I.. art-benchmark.c -o art-benchmark && ./art-benchmark [len]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* counts the bytes allocated by the containers, the templates below call these */
+typedef union alloc_header { size_t size; double d; void *p; long l; } alloc_header;
+
+size_t heap_bytes;
+
+void *counted_malloc(size_t size)
+{
+	alloc_header *h;
+	h = malloc(sizeof(alloc_header) + size);
+	if (!h) return NULL;
+	h->size = size;
+	heap_bytes += size;
+	return h + 1;
+}
+
+void counted_free(void *p)
+{
+	alloc_header *h;
+	if (!p) return;
+	h = (alloc_header *)p - 1;
+	heap_bytes -= h->size;
+	free(h);
+}
+
+void *counted_realloc(void *p, size_t size)
+{
+	alloc_header *h;
+	size_t old;
+	if (!p) return counted_malloc(size);
+	h = (alloc_header *)p - 1;
+	old = h->size;
+	h = realloc(h, sizeof(alloc_header) + size);
+	if (!h) return NULL;
+	h->size = size;
+	heap_bytes += size - old;
+	return h + 1;
+}
+
+#define malloc(size) counted_malloc(size)
+#define realloc(p, size) counted_realloc(p, size)
+#define free(p) counted_free(p)
+
+#include "hmap.h"
+#include "art.h"
+
+#define LEN 500000 /* default number of keys */
+
+uint32_t djb2(const char *str);
+
+HMAP_PROTO(const char *, int, str_map);
+HMAP(const char *, int, str_map, strcmp, djb2);
+
+ART_PROTO(int, str_tree);
+ART(int, str_tree);
+
+uint32_t djb2(const char *str)
+{
+	uint32_t hash;
+	hash = 5381;
+	while (*str) {
+		hash = hash * 33 + (unsigned char)*str++;
+	}
+	return hash;
+}
+
+uint32_t rng_state = 2463534242u;
+
+/* xorshift32, rand() only gives 15 bits on some platforms */
+uint32_t rng(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+double seconds(clock_t start)
+{
+	return (clock() - start) * 1.0 / CLOCKS_PER_SEC;
+}
+
+const char *hosts[] = {"www.example.com", "api.example.com", "cdn.example.net", "shop.example.org"};
+const char *sections[] = {"users", "posts", "api/v2/items", "static/images", "search/results"};
+const char *dirs[] = {"usr/lib/x86_64-linux-gnu", "usr/share/doc", "usr/include/linux",
+	"usr/local/lib/python3/site-packages", "home/user/projects/src"};
+const char *exts[] = {".c", ".h", ".so.1", ".py", ".txt"};
+
+/* writes the i-th key of a set to buf, distinct for each i; the numbers are spread by rng */
+void make_key(char *buf, int paths, uint32_t i, uint32_t r)
+{
+	if (paths) {
+		sprintf(buf, "/%s/pkg%lu/module%lu/file%lu%s", dirs[r % 5], (unsigned long)(r / 5 % 300),
+				(unsigned long)(i / 50), (unsigned long)i, exts[r / 1500 % 5]);
+	} else {
+		sprintf(buf, "https://%s/%s/%lu/comments/%lu", hosts[r % 4], sections[r / 4 % 5],
+				(unsigned long)(i / 8), (unsigned long)i);
+	}
+}
+
+/* counts the keys of a prefix scan */
+int count_key(const char *key, size_t len, int *value, void *ctx)
+{
+	(void)key;
+	(void)len;
+	(void)value;
+	++*(long *)ctx;
+	return 0;
+}
+
+void run(const char *name, int paths, int len)
+{
+	char **keys, **misses, **copies;
+	char buf[256];
+	str_map *map;
+	str_tree *tree;
+	size_t base, map_bytes, tree_bytes;
+	long count;
+	int i, sum;
+	clock_t start;
+
+	keys = (malloc)(len * sizeof(char *));
+	misses = (malloc)(len * sizeof(char *));
+	copies = (malloc)(len * sizeof(char *));
+	if (!keys || !misses || !copies) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	for (i=0; i<len; ++i) {
+		make_key(buf, paths, i, rng());
+		keys[i] = (malloc)(strlen(buf) + 1);
+		make_key(buf + 128, paths, len + i, rng());
+		misses[i] = (malloc)(strlen(buf + 128) + 1);
+		if (!keys[i] || !misses[i]) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+		strcpy(keys[i], buf);
+		strcpy(misses[i], buf + 128);
+	}
+	printf("%s keys, e.g. %s\n", name, buf);
+
+	/* the map points to copies of the keys it owns, like a map of keys read from input would */
+	base = heap_bytes;
+	start = clock();
+	map = str_map_new();
+	for (i=0; i<len; ++i) {
+		copies[i] = malloc(strlen(keys[i]) + 1);
+		strcpy(copies[i], keys[i]);
+		str_map_set(map, copies[i], i);
+	}
+	printf("%-22s %8.3f s\n", "hmap insert", seconds(start));
+	map_bytes = heap_bytes - base;
+
+	base = heap_bytes;
+	start = clock();
+	tree = str_tree_new();
+	for (i=0; i<len; ++i) {
+		str_tree_set(tree, keys[i], strlen(keys[i]), i);
+	}
+	printf("%-22s %8.3f s\n", "art insert", seconds(start));
+	tree_bytes = heap_bytes - base;
+
+	/* look the keys up in random order */
+	for (i=len-1; i>0; --i) {
+		char *swap;
+		int j = rng() % (i + 1);
+		swap = keys[i];
+		keys[i] = keys[j];
+		keys[j] = swap;
+	}
+
+	/* the sums keep the lookups from being optimized out */
+	sum = 0;
+	start = clock();
+	for (i=0; i<len; ++i) {
+		sum += str_map_get(map, keys[i]);
+	}
+	printf("%-22s %8.3f s (%d)\n", "hmap hit lookup", seconds(start), sum);
+
+	sum = 0;
+	start = clock();
+	for (i=0; i<len; ++i) {
+		const char *key = keys[i];
+		int value = 0;
+		str_tree_get(tree, key, strlen(key), &value);
+		sum += value;
+	}
+	printf("%-22s %8.3f s (%d)\n", "art hit lookup", seconds(start), sum);
+
+	sum = 0;
+	start = clock();
+	for (i=0; i<len; ++i) {
+		sum += str_map_contains(map, misses[i]);
+	}
+	printf("%-22s %8.3f s (%d)\n", "hmap miss lookup", seconds(start), sum);
+
+	sum = 0;
+	start = clock();
+	for (i=0; i<len; ++i) {
+		sum += str_tree_get(tree, misses[i], strlen(misses[i]), NULL);
+	}
+	printf("%-22s %8.3f s (%d)\n", "art miss lookup", seconds(start), sum);
+
+	count = 0;
+	start = clock();
+	str_tree_prefix_iterate(tree, keys[0], strlen(keys[0]) / 2, count_key, &count);
+	printf("%-22s %8.3f s (%ld keys)\n", "art prefix scan", seconds(start), count);
+
+	printf("%-22s %8.1f\n", "hmap bytes per key", map_bytes * 1.0 / len);
+	printf("%-22s %8.1f\n\n", "art bytes per key", tree_bytes * 1.0 / len);
+
+	str_map_free(map);
+	str_tree_free(tree);
+	for (i=0; i<len; ++i) {
+		free(copies[i]);
+		(free)(keys[i]);
+		(free)(misses[i]);
+	}
+	(free)(copies);
+	(free)(keys);
+	(free)(misses);
+}
+
+int main(int argc, char **argv)
+{
+	int len;
+	len = argc > 1 ? atoi(argv[1]) : LEN;
+	if (len < 1) {
+		fprintf(stderr, "usage: %s [len]\n", argv[0]);
+		return 1;
+	}
+	printf("%d keys\n\n", len);
+	run("URL", 0, len);
+	run("path", 1, len);
+	return 0;
+}
@@ -0,0 +1,698 @@
+/*
+ * Runs the same workloads on every container template and prints the timings
+ * as CSV or JSON, to compare containers and to catch performance regressions
+ * between versions.
+ *
+ * make bench && ./bench [-n keys] [-f csv|json] [-o file] [container...]
+ *
+ * The containers are alist, llist, hmap, hset, ohmap, tree and frozen_tree (all
+ * by default);
+ * the keys are distinct pseudo-random 32-bit integers. The workloads, each run
+ * n times (ops) on a container of up to n elements:
+ * - seq_insert: appends to a list, inserts the keys 0 to n-1 into the others
+ * - rand_insert: inserts the random keys (for lists the same as seq_insert)
+ * - hit_lookup: looks up inserted keys in random order (lists: random positions)
+ * - miss_lookup: looks up keys which aren't in the container
+ * - zipf_lookup: looks up inserted keys with a zipfian skew (s = 0.99), a few
+ *   keys take most of the lookups like in most caches
+ * - delete_churn: deletes a key and inserts a new one, keeping the size (lists:
+ *   pops an element and appends a new one, a queue for llist)
+ * - iterate: visits all elements, ops is the number of elements
+ * - freeze: copies the tree of the random keys into a frozen tree, ops is 1
+ * Workloads which don't apply to a container (e.g. lookups in a llist, which
+ * are O(n), or deletes in the tree, which tree.h doesn't have) are skipped;
+ * the tree is an unbalanced binary search tree built from TREE nodes, so its
+ * sequential insert is skipped as well. frozen_tree runs the lookups on the
+ * frozen copy of that tree, after freeing the tree.
+ *
+ * Columns: ns_per_op is the total time divided by ops; p50, p99 and p999 are
+ * percentiles of the time per operation, measured on batches of BATCH
+ * operations, since a clock call takes as long as a lookup; allocs and frees
+ * count the calls of the allocator during the workload and peak_heap is the
+ * most memory allocated at once by all live containers during it, both
+ * measured by the allocator of the containers (CONTAINER_MALLOC etc. of
+ * container.h), which wraps malloc, realloc and free; max_rss_kb is the
+ * peak resident set size of the process so far.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#define BATCH 16 /* operations per latency sample */
+#define ZIPF_S 0.99 /* zipf exponent */
+
+/* the allocator counting the allocations of the containers */
+typedef union alloc_header { size_t size; long double ld; void *p; long long ll; } alloc_header; /* keeps malloc's alignment */
+
+unsigned long alloc_count, free_count;
+size_t heap_bytes, peak_heap_bytes;
+
+void *bench_malloc(size_t size)
+{
+	alloc_header *h;
+	h = malloc(sizeof(alloc_header) + size);
+	if (!h) return NULL;
+	h->size = size;
+	++alloc_count;
+	heap_bytes += size;
+	if (heap_bytes > peak_heap_bytes) peak_heap_bytes = heap_bytes;
+	return h + 1;
+}
+
+void bench_free(void *p)
+{
+	alloc_header *h;
+	if (!p) return;
+	h = (alloc_header *)p - 1;
+	++free_count;
+	heap_bytes -= h->size;
+	free(h);
+}
+
+void *bench_realloc(void *p, size_t size)
+{
+	alloc_header *h;
+	size_t old;
+	if (!p) return bench_malloc(size);
+	h = (alloc_header *)p - 1;
+	old = h->size;
+	h = realloc(h, sizeof(alloc_header) + size);
+	if (!h) return NULL;
+	h->size = size;
+	++alloc_count;
+	heap_bytes += size - old;
+	if (heap_bytes > peak_heap_bytes) peak_heap_bytes = heap_bytes;
+	return h + 1;
+}
+
+/* the templates expanded below call the wrappers, the benchmark's own arrays aren't counted */
+#define CONTAINER_MALLOC(size) bench_malloc(size)
+#define CONTAINER_REALLOC(p, size) bench_realloc(p, size)
+#define CONTAINER_FREE(p) bench_free(p)
+
+#include "alist.h"
+#include "llist.h"
+#include "hmap.h"
+#include "hset.h"
+#include "ohmap.h"
+#include "tree.h"
+
+/* the finalizer of MurmurHash3, a bijection, so distinct inputs give distinct keys */
+uint32_t mix32(uint32_t h)
+{
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+#define CMP(a, b) ((a) < (b) ? -1 : (a) > (b))
+
+ALIST_PROTO(uint32_t, u32_list);
+ALIST(uint32_t, u32_list);
+LLIST_PROTO(uint32_t, u32_llist);
+LLIST(uint32_t, u32_llist);
+HMAP_PROTO(uint32_t, uint32_t, u32_map);
+HMAP(uint32_t, uint32_t, u32_map, CMP, mix32);
+HSET_PROTO(uint32_t, u32_set);
+HSET(uint32_t, u32_set, CMP, mix32);
+HMAP_ORDERED_PROTO(uint32_t, uint32_t, u32_omap);
+HMAP_ORDERED(uint32_t, uint32_t, u32_omap, CMP, mix32);
+TREE_PROTO(uint32_t, u32_tree)
+TREE(uint32_t, u32_tree);
+TREE_FROZEN_PROTO(uint32_t, u32_tree);
+TREE_FROZEN(uint32_t, u32_tree, CMP);
+
+typedef struct result {
+	const char *container;
+	const char *workload;
+	long n;
+	long ops;
+	double total_ns;
+	double p50, p99, p999;
+	unsigned long allocs, frees;
+	size_t peak_heap;
+	long max_rss_kb;
+} result;
+
+ALIST_PROTO(result, result_list);
+ALIST(result, result_list);
+
+long n = 1000000;
+uint32_t *keys; /* the inserted keys, mix32(i) for i < n */
+uint32_t *miss_keys; /* keys which are never inserted, mix32(i) for n <= i < 2n */
+uint32_t *order; /* a random permutation of 0 to n-1 */
+uint32_t *zipf; /* indices of keys with zipfian frequencies */
+result_list *results;
+double *samples;
+long sample_count;
+result current;
+volatile uint64_t sink; /* keeps the compiler from dropping the lookups */
+
+uint64_t rng_state = 88172645463325252ull;
+
+/* xorshift64 */
+uint64_t rng(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return rng_state;
+}
+
+double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void begin(const char *container, const char *workload)
+{
+	memset(&current, 0, sizeof(current));
+	current.container = container;
+	current.workload = workload;
+	current.n = n;
+	sample_count = 0;
+	alloc_count = 0;
+	free_count = 0;
+	peak_heap_bytes = heap_bytes;
+}
+
+int cmp_double(const void *a, const void *b)
+{
+	return CMP(*(const double *)a, *(const double *)b);
+}
+
+double percentile(double p)
+{
+	long i;
+	if (!sample_count) return 0;
+	i = (long)(p * sample_count);
+	return samples[i < sample_count ? i : sample_count-1];
+}
+
+void end(void)
+{
+	struct rusage usage;
+	current.allocs = alloc_count;
+	current.frees = free_count;
+	current.peak_heap = peak_heap_bytes;
+	qsort(samples, sample_count, sizeof(double), cmp_double);
+	current.p50 = percentile(0.5);
+	current.p99 = percentile(0.99);
+	current.p999 = percentile(0.999);
+	getrusage(RUSAGE_SELF, &usage);
+	current.max_rss_kb = usage.ru_maxrss;
+	result_list_insert(results, current, -1);
+}
+
+/* runs STMT for i from 0 to OPS-1, timing batches of BATCH runs */
+#define TIMED(OPS, STMT) do { \
+		long i, batch_start_, batch_end_; \
+		double start_, t_; \
+		for (i=0; i<(OPS); ) { \
+			batch_start_ = i; \
+			batch_end_ = i+BATCH < (OPS) ? i+BATCH : (OPS); \
+			start_ = now_ns(); \
+			for (; i<batch_end_; ++i) { STMT; } \
+			t_ = now_ns() - start_; \
+			current.total_ns += t_; \
+			samples[sample_count++] = t_ / (batch_end_ - batch_start_); \
+		} \
+		current.ops += (OPS); \
+	} while (0)
+
+void bench_alist(void)
+{
+	u32_list *l;
+	uint32_t sum;
+
+	begin("alist", "seq_insert");
+	l = u32_list_new();
+	TIMED(n, u32_list_insert(l, keys[i], -1));
+	end();
+
+	begin("alist", "hit_lookup");
+	TIMED(n, sink += u32_list_get(l, order[i]));
+	end();
+
+	begin("alist", "zipf_lookup");
+	TIMED(n, sink += u32_list_get(l, zipf[i]));
+	end();
+
+	begin("alist", "delete_churn");
+	TIMED(n, u32_list_pop(l, u32_list_size(l)-1); u32_list_insert(l, miss_keys[i], -1));
+	end();
+
+	begin("alist", "iterate");
+	sum = 0;
+	TIMED(u32_list_size(l), sum += l->arr[i]);
+	sink += sum;
+	end();
+
+	u32_list_free(l);
+}
+
+void bench_llist(void)
+{
+	u32_llist *l;
+	u32_llist_iterator iter;
+	uint32_t sum;
+
+	begin("llist", "seq_insert");
+	l = u32_llist_new();
+	TIMED(n, u32_llist_insert(l, keys[i], -1));
+	end();
+
+	begin("llist", "delete_churn");
+	TIMED(n, sink += u32_llist_pop(l, 0); u32_llist_insert(l, miss_keys[i], -1));
+	end();
+
+	begin("llist", "iterate");
+	sum = 0;
+	iter = u32_llist_iterate(l);
+	TIMED(u32_llist_size(l), u32_llist_next(l, &iter); sum += u32_llist_get_at(l, iter));
+	sink += sum;
+	end();
+
+	u32_llist_free(l);
+}
+
+void bench_hmap(void)
+{
+	u32_map *m;
+	u32_map_iterator iter;
+	uint32_t sum;
+
+	begin("hmap", "seq_insert");
+	m = u32_map_new();
+	TIMED(n, u32_map_set(m, i, i));
+	end();
+	u32_map_free(m);
+
+	begin("hmap", "rand_insert");
+	m = u32_map_new();
+	TIMED(n, u32_map_set(m, keys[i], i));
+	end();
+
+	begin("hmap", "hit_lookup");
+	TIMED(n, sink += u32_map_get(m, keys[order[i]]));
+	end();
+
+	begin("hmap", "miss_lookup");
+	TIMED(n, sink += u32_map_contains(m, miss_keys[i]));
+	end();
+
+	begin("hmap", "zipf_lookup");
+	TIMED(n, sink += u32_map_get(m, keys[zipf[i]]));
+	end();
+
+	begin("hmap", "delete_churn");
+	TIMED(n, u32_map_delete(m, keys[order[i]]); u32_map_set(m, miss_keys[i], i));
+	end();
+
+	begin("hmap", "iterate");
+	sum = 0;
+	iter = u32_map_iterate(m);
+	TIMED(u32_map_size(m), u32_map_next(m, &iter); sum += u32_map_value_at(m, iter));
+	sink += sum;
+	end();
+
+	u32_map_free(m);
+}
+
+void bench_hset(void)
+{
+	u32_set *s;
+	u32_set_iterator iter;
+	uint32_t sum;
+
+	begin("hset", "seq_insert");
+	s = u32_set_new();
+	TIMED(n, u32_set_add(s, i));
+	end();
+	u32_set_free(s);
+
+	begin("hset", "rand_insert");
+	s = u32_set_new();
+	TIMED(n, u32_set_add(s, keys[i]));
+	end();
+
+	begin("hset", "hit_lookup");
+	TIMED(n, sink += u32_set_contains(s, keys[order[i]]));
+	end();
+
+	begin("hset", "miss_lookup");
+	TIMED(n, sink += u32_set_contains(s, miss_keys[i]));
+	end();
+
+	begin("hset", "zipf_lookup");
+	TIMED(n, sink += u32_set_contains(s, keys[zipf[i]]));
+	end();
+
+	begin("hset", "delete_churn");
+	TIMED(n, u32_set_remove(s, keys[order[i]]); u32_set_add(s, miss_keys[i]));
+	end();
+
+	begin("hset", "iterate");
+	sum = 0;
+	iter = u32_set_iterate(s);
+	TIMED(u32_set_size(s), u32_set_next(s, &iter); sum += u32_set_key_at(s, iter));
+	sink += sum;
+	end();
+
+	u32_set_free(s);
+}
+
+void bench_ohmap(void)
+{
+	u32_omap *m;
+	u32_omap_iterator iter;
+	uint32_t sum;
+
+	begin("ohmap", "seq_insert");
+	m = u32_omap_new();
+	TIMED(n, u32_omap_set(m, i, i));
+	end();
+	u32_omap_free(m);
+
+	begin("ohmap", "rand_insert");
+	m = u32_omap_new();
+	TIMED(n, u32_omap_set(m, keys[i], i));
+	end();
+
+	begin("ohmap", "hit_lookup");
+	TIMED(n, sink += u32_omap_get(m, keys[order[i]]));
+	end();
+
+	begin("ohmap", "miss_lookup");
+	TIMED(n, sink += u32_omap_contains(m, miss_keys[i]));
+	end();
+
+	begin("ohmap", "zipf_lookup");
+	TIMED(n, sink += u32_omap_get(m, keys[zipf[i]]));
+	end();
+
+	begin("ohmap", "delete_churn");
+	TIMED(n, u32_omap_delete(m, keys[order[i]]); u32_omap_set(m, miss_keys[i], i));
+	end();
+
+	begin("ohmap", "iterate");
+	sum = 0;
+	iter = u32_omap_iterate(m);
+	TIMED(u32_omap_size(m), u32_omap_next(m, &iter); sum += u32_omap_value_at(m, iter));
+	sink += sum;
+	end();
+
+	u32_omap_free(m);
+}
+
+/* inserts key into the binary search tree *root unless it's there, returns 0 on malloc failure */
+int tree_insert(u32_tree **root, uint32_t key)
+{
+	while (*root) {
+		if (key == (*root)->item) return 1;
+		root = key < (*root)->item ? &(*root)->left : &(*root)->right;
+	}
+	*root = u32_tree_new(key);
+	return *root != NULL;
+}
+
+int tree_contains(const u32_tree *t, uint32_t key)
+{
+	while (t && t->item != key) {
+		t = key < t->item ? t->left : t->right;
+	}
+	return t != NULL;
+}
+
+/* an in-order iterator with an explicit stack, the tree may be deep */
+typedef struct tree_iter {
+	const u32_tree **stack;
+	long top;
+	const u32_tree *next;
+} tree_iter;
+
+/* returns the next node or NULL */
+const u32_tree *tree_iter_next(tree_iter *it)
+{
+	const u32_tree *t;
+	for (t=it->next; t; t=t->left) {
+		it->stack[it->top++] = t;
+	}
+	if (!it->top) return NULL;
+	t = it->stack[--it->top];
+	it->next = t->right;
+	return t;
+}
+
+void bench_tree(void)
+{
+	u32_tree *t;
+	tree_iter iter;
+	uint32_t sum;
+
+	t = NULL;
+	begin("tree", "rand_insert");
+	TIMED(n, tree_insert(&t, keys[i]));
+	end();
+
+	begin("tree", "hit_lookup");
+	TIMED(n, sink += tree_contains(t, keys[order[i]]));
+	end();
+
+	begin("tree", "miss_lookup");
+	TIMED(n, sink += tree_contains(t, miss_keys[i]));
+	end();
+
+	begin("tree", "zipf_lookup");
+	TIMED(n, sink += tree_contains(t, keys[zipf[i]]));
+	end();
+
+	iter.stack = malloc(n * sizeof(*iter.stack));
+	iter.top = 0;
+	iter.next = t;
+	sum = 0;
+	begin("tree", "iterate");
+	TIMED(n, sum += tree_iter_next(&iter)->item);
+	sink += sum;
+	end();
+	free(iter.stack);
+
+	u32_tree_free_all(t);
+}
+
+void bench_frozen_tree(void)
+{
+	u32_tree *t;
+	u32_tree_frozen *f;
+	u32_tree_frozen_iterator iter;
+	uint32_t sum;
+	long i;
+
+	t = NULL;
+	for (i=0; i<n; ++i) {
+		tree_insert(&t, keys[i]);
+	}
+	begin("frozen_tree", "freeze");
+	TIMED(1, f = u32_tree_freeze(t));
+	end();
+	u32_tree_free_all(t);
+	if (!f) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+
+	begin("frozen_tree", "hit_lookup");
+	TIMED(n, sink += u32_tree_frozen_find(f, keys[order[i]]) != 0);
+	end();
+
+	begin("frozen_tree", "miss_lookup");
+	TIMED(n, sink += u32_tree_frozen_find(f, miss_keys[i]) != 0);
+	end();
+
+	begin("frozen_tree", "zipf_lookup");
+	TIMED(n, sink += u32_tree_frozen_find(f, keys[zipf[i]]) != 0);
+	end();
+
+	iter = u32_tree_frozen_iterate(f);
+	sum = 0;
+	begin("frozen_tree", "iterate");
+	TIMED(n, u32_tree_frozen_next(f, &iter); sum += u32_tree_frozen_get_at(f, iter));
+	sink += sum;
+	end();
+
+	u32_tree_frozen_free(f);
+}
+
+/* fills zipf with n samples of indices 0 to n-1, index k drawn with probability ~ 1/(k+1)^s */
+int make_zipf(void)
+{
+	double *cdf, sum, u;
+	long i, lo, hi, mid;
+	cdf = malloc(n * sizeof(double));
+	if (!cdf) return 0;
+	sum = 0;
+	for (i=0; i<n; ++i) {
+		sum += 1.0 / pow(i+1, ZIPF_S);
+		cdf[i] = sum;
+	}
+	for (i=0; i<n; ++i) {
+		u = (rng() >> 11) * (1.0 / 9007199254740992.0) * sum;
+		for (lo=0, hi=n-1; lo<hi; ) {
+			mid = lo + (hi-lo)/2;
+			if (cdf[mid] < u) lo = mid+1;
+			else hi = mid;
+		}
+		/* spread the popular indices over the keys */
+		zipf[i] = order[lo];
+	}
+	free(cdf);
+	return 1;
+}
+
+void print_csv(FILE *f)
+{
+	result *r;
+	container_size i;
+	fprintf(f, "container,workload,n,ops,total_ms,ns_per_op,p50_ns,p99_ns,p999_ns,allocs,frees,peak_heap,max_rss_kb\n");
+	for (i=0; i<results->len; ++i) {
+		r = &results->arr[i];
+		fprintf(f, "%s,%s,%ld,%ld,%.3f,%.2f,%.2f,%.2f,%.2f,%lu,%lu,%lu,%ld\n",
+				r->container, r->workload, r->n, r->ops, r->total_ns / 1e6, r->total_ns / r->ops,
+				r->p50, r->p99, r->p999, r->allocs, r->frees, (unsigned long)r->peak_heap, r->max_rss_kb);
+	}
+}
+
+void print_json(FILE *f)
+{
+	result *r;
+	container_size i;
+	fprintf(f, "[\n");
+	for (i=0; i<results->len; ++i) {
+		r = &results->arr[i];
+		fprintf(f, "  {\"container\": \"%s\", \"workload\": \"%s\", \"n\": %ld, \"ops\": %ld, "
+				"\"total_ms\": %.3f, \"ns_per_op\": %.2f, \"p50_ns\": %.2f, \"p99_ns\": %.2f, \"p999_ns\": %.2f, "
+				"\"allocs\": %lu, \"frees\": %lu, \"peak_heap\": %lu, \"max_rss_kb\": %ld}%s\n",
+				r->container, r->workload, r->n, r->ops, r->total_ns / 1e6, r->total_ns / r->ops,
+				r->p50, r->p99, r->p999, r->allocs, r->frees, (unsigned long)r->peak_heap, r->max_rss_kb,
+				i+1 < results->len ? "," : "");
+	}
+	fprintf(f, "]\n");
+}
+
+struct {
+	const char *name;
+	void (*run)(void);
+} benches[] = {
+	{"alist", bench_alist},
+	{"llist", bench_llist},
+	{"hmap", bench_hmap},
+	{"hset", bench_hset},
+	{"ohmap", bench_ohmap},
+	{"tree", bench_tree},
+	{"frozen_tree", bench_frozen_tree},
+};
+
+#define BENCH_COUNT ((int)(sizeof(benches) / sizeof(benches[0])))
+
+void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-n keys] [-f csv|json] [-o file] [container...]\n", prog);
+	exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *out;
+	const char *format;
+	uint32_t tmp;
+	long i, j;
+	int opt, k, selected;
+
+	format = "csv";
+	out = stdout;
+	while ((opt = getopt(argc, argv, "n:f:o:")) != -1) {
+		switch (opt) {
+		case 'n':
+			n = atol(optarg);
+			if (n <= 0 || n > UINT32_MAX/2) usage(argv[0]);
+			break;
+		case 'f':
+			format = optarg;
+			if (strcmp(format, "csv") && strcmp(format, "json")) usage(argv[0]);
+			break;
+		case 'o':
+			out = fopen(optarg, "w");
+			if (!out) {
+				perror(optarg);
+				return 1;
+			}
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	for (i=optind; i<argc; ++i) {
+		for (k=0; k<BENCH_COUNT && strcmp(argv[i], benches[k].name); ++k);
+		if (k == BENCH_COUNT) usage(argv[0]);
+	}
+
+	keys = malloc(n * sizeof(uint32_t));
+	miss_keys = malloc(n * sizeof(uint32_t));
+	order = malloc(n * sizeof(uint32_t));
+	zipf = malloc(n * sizeof(uint32_t));
+	samples = malloc((n / BATCH + 1) * sizeof(double));
+	results = result_list_new();
+	if (!keys || !miss_keys || !order || !zipf || !samples || !results) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (i=0; i<n; ++i) {
+		keys[i] = mix32(i);
+		miss_keys[i] = mix32(n + i);
+		order[i] = i;
+	}
+	/* Fisher-Yates */
+	for (i=n-1; i>0; --i) {
+		j = rng() % (i+1);
+		tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+	if (!make_zipf()) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	for (k=0; k<BENCH_COUNT; ++k) {
+		selected = optind == argc;
+		for (i=optind; i<argc; ++i) selected |= !strcmp(argv[i], benches[k].name);
+		if (selected) benches[k].run();
+	}
+
+	if (!strcmp(format, "csv")) {
+		print_csv(out);
+	} else {
+		print_json(out);
+	}
+	if (out != stdout) fclose(out);
+
+	result_list_free(results);
+	free(keys);
+	free(miss_keys);
+	free(order);
+	free(zipf);
+	free(samples);
+
+	return 0;
+}
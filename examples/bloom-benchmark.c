@@ -0,0 +1,144 @@
+/*
+ * Compares lookups of keys which are mostly not in a map, in HMAP and
+ * HMAP_FILTERED, and the build of a BLOOM filter key by key and in bulk. The
+ * filter saves the bucket and entry cache misses of most of the lookups, but
+ * adds the hashing of its bits to all of them; which one wins depends on how
+ * many misses of independent lookups the CPU overlaps, try a few lengths.
+ *
+ * gcc -O2 -I.. bloom-benchmark.c -o bloom-benchmark && ./bloom-benchmark [len]
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "hmap.h"
+
+#define LEN 4000000 /* default number of map entries */
+#define LOOKUPS 4000000 /* number of lookups, 1 in 16 hits */
+
+#define CMP(a, b) ((a) < (b) ? -1 : (a) > (b))
+
+uint32_t mix(uint32_t x);
+
+HMAP_PROTO(uint32_t, uint32_t, plain_map);
+HMAP(uint32_t, uint32_t, plain_map, CMP, mix);
+
+HMAP_FILTERED_PROTO(uint32_t, uint32_t, filtered_map);
+HMAP_FILTERED(uint32_t, uint32_t, filtered_map, CMP, mix);
+
+BLOOM_PROTO(uint32_t, filter);
+BLOOM(uint32_t, filter, mix);
+
+/* a finalizer of MurmurHash3, the keys are sequential */
+uint32_t mix(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x85ebca6bU;
+	x ^= x >> 13;
+	x *= 0xc2b2ae35U;
+	x ^= x >> 16;
+	return x;
+}
+
+uint32_t rng_state = 2463534242u;
+
+/* xorshift32, rand() only gives 15 bits on some platforms */
+uint32_t rng(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+double seconds(clock_t start)
+{
+	return (clock() - start) * 1.0 / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+	plain_map *plain;
+	filtered_map *filtered;
+	filter *f;
+	uint32_t *keys, *queries;
+	uint32_t sum;
+	int len, i;
+	clock_t start;
+
+	len = argc > 1 ? atoi(argv[1]) : LEN;
+	if (len < 1) {
+		fprintf(stderr, "usage: %s [len]\n", argv[0]);
+		return 1;
+	}
+	plain = plain_map_new();
+	filtered = filtered_map_new();
+	f = filter_new(0);
+	keys = malloc(len * sizeof(uint32_t));
+	queries = malloc(LOOKUPS * sizeof(uint32_t));
+	if (!plain || !filtered || !f || !keys || !queries) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	/* the even numbers are in the maps, the odd ones aren't */
+	for (i=0; i<len; ++i) {
+		keys[i] = 2 * (uint32_t)i;
+		if (!plain_map_set(plain, keys[i], i) || !filtered_map_set(filtered, keys[i], i)) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+	}
+	for (i=0; i<LOOKUPS; ++i) {
+		queries[i] = 2 * (rng() % len) + (i % 16 != 0);
+	}
+
+	printf("%d entries, %d lookups\n", len, LOOKUPS);
+
+	/* the sums keep the lookups from being optimized out */
+	sum = 0;
+	start = clock();
+	for (i=0; i<LOOKUPS; ++i) {
+		sum += plain_map_contains(plain, queries[i]);
+	}
+	printf("%-22s %8.3f s (%u)\n", "hmap", seconds(start), sum);
+
+	sum = 0;
+	start = clock();
+	for (i=0; i<LOOKUPS; ++i) {
+		sum += filtered_map_contains(filtered, queries[i]);
+	}
+	printf("%-22s %8.3f s (%u)\n", "filtered hmap", seconds(start), sum);
+
+	printf("%d keys\n", len);
+
+	filter_destroy(f);
+	start = clock();
+	if (!filter_init(f, len)) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (i=0; i<len; ++i) {
+		filter_add(f, keys[i]);
+	}
+	printf("%-22s %8.3f s\n", "bloom add", seconds(start));
+
+	start = clock();
+	if (!filter_build(f, keys, len)) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	printf("%-22s %8.3f s\n", "bloom build", seconds(start));
+
+	sum = 0;
+	for (i=0; i<LOOKUPS; ++i) {
+		sum += filter_contains(f, queries[i]) && queries[i] % 2;
+	}
+	printf("false positives        %8.3f %%\n", sum * 100.0 / (LOOKUPS - LOOKUPS/16));
+
+	free(queries);
+	free(keys);
+	filter_free(f);
+	plain_map_free(plain);
+	filtered_map_free(filtered);
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Moves nodes between doubly-linked lists without allocating: linking and
+ * unlinking single nodes, splicing whole lists and ranges of nodes, and
+ * checks the lists in both directions after each step.
+ */
+
+#include <stdio.h>
+#include "dlist.h"
+
+DLIST_PROTO(int, int_dlist);
+DLIST(int, int_dlist);
+
+/* prints the list and returns 1 if it is {expected[0], ..., expected[len-1]} both ways */
+int check(const char *name, const int_dlist *list, const int *expected, int len)
+{
+	int_dlist_iterator i;
+	int n;
+
+	printf("%s:", name);
+	n = 0;
+	for (i = int_dlist_iterate(list); int_dlist_next(list, &i); ++n) {
+		printf(" %d", int_dlist_get_at(list, i));
+		if (n >= len || int_dlist_get_at(list, i) != expected[n]) {
+			printf(" (wrong)\n");
+			return 0;
+		}
+	}
+	printf("\n");
+	if (n != len || int_dlist_size(list) != len) return 0;
+	for (i = int_dlist_iterate(list); int_dlist_prev(list, &i); ) {
+		if (int_dlist_get_at(list, i) != expected[--n]) return 0;
+	}
+	return n == 0;
+}
+
+/* fills list with the numbers from start to end - 1 */
+int fill(int_dlist *list, int start, int end)
+{
+	for (; start < end; ++start) {
+		if (!int_dlist_insert(list, start, -1)) return 0;
+	}
+	return 1;
+}
+
+int main(void)
+{
+	int_dlist a, b;
+	int_dlist_node *node, *first, *last;
+	static const int unlinked[] = {1, 2, 3, 4};
+	static const int linked[] = {0, 1, 2, 4, 3};
+	static const int spliced[] = {0, 1, 10, 11, 12, 2, 4, 3};
+	static const int counted[] = {0, 1, 2, 4, 3, 11, 12, 20};
+	static const int rest[] = {10, 21};
+	static const int moved[] = {1, 2, 4, 3, 11, 12, 0, 20};
+	static const int all[] = {1, 2, 4, 3, 11, 12, 0, 20, 10, 21};
+
+	int_dlist_init(&a);
+	int_dlist_init(&b);
+	if (!fill(&a, 0, 5) || !fill(&b, 10, 13)) return 1;
+
+	/* unlink the head and link it back, then move the tail before the node before it */
+	node = a.first;
+	int_dlist_unlink(&a, node);
+	if (!check("unlink 0", &a, unlinked, 4)) return 1;
+	int_dlist_link(&a, node, a.first);
+	node = a.last;
+	int_dlist_unlink(&a, node);
+	int_dlist_link(&a, node, a.last);
+	if (!check("link 0 and 4", &a, linked, 5)) return 1;
+
+	/* move all of b before the third element of a */
+	int_dlist_splice(&a, a.first->next->next, &b);
+	if (!check("splice b", &a, spliced, 8) || !check("b", &b, NULL, 0)) return 1;
+
+	/* move 10..12 back to b, then 11 and 12 (counted with -1) and 20 to the tail of a */
+	first = a.first->next->next;
+	last = first->next->next;
+	int_dlist_splice_range(&b, NULL, &a, first, last, 3);
+	if (!check("range to b", &a, linked, 5)) return 1;
+	if (!fill(&b, 20, 22)) return 1;
+	int_dlist_splice_range(&a, NULL, &b, b.first->next, b.first->next->next, -1);
+	int_dlist_splice_range(&a, NULL, &b, b.first->next, b.first->next, 1);
+	if (!check("counted range", &a, counted, 8)) return 1;
+	if (!check("b", &b, rest, 2)) return 1;
+
+	/* a range can move within its own list, here the head before the last node */
+	int_dlist_splice_range(&a, a.last, &a, a.first, a.first, -1);
+	if (!check("within a", &a, moved, 8)) return 1;
+
+	/* all of a before the head of b, then all of b into the emptied a */
+	int_dlist_splice(&b, b.first, &a);
+	if (!check("a", &a, NULL, 0)) return 1;
+	int_dlist_splice(&a, NULL, &b);
+	if (!check("back and forth", &a, all, 10) || !check("b", &b, NULL, 0)) return 1;
+
+	int_dlist_destroy(&a);
+	int_dlist_destroy(&b);
+	return 0;
+}
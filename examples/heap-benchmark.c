@@ -0,0 +1,140 @@
+/*
+ * Compares binary and 4-ary heaps generated by HEAP with a priority queue kept
+ * in an alist sorted in descending order (so the minimum is popped from the
+ * tail and each push shifts the elements after its position), on the hold
+ * model of timer queues: each operation pops the minimum and pushes a new
+ * element a random distance after it.
+ *
+ * gcc -O2 -I.. heap-benchmark.c -o heap-benchmark && ./heap-benchmark [len] [ops]
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "alist.h"
+#include "heap.h"
+
+#define LEN 10000 /* default number of elements in the queues */
+#define OPS 200000 /* default number of pop and push pairs */
+
+#define CMP(a, b) ((a) < (b) ? -1 : (a) > (b))
+#define REVERSE_CMP(a, b) CMP(b, a)
+
+ALIST_PROTO(uint32_t, sorted_list);
+ALIST(uint32_t, sorted_list);
+ALIST_SORT_PROTO(uint32_t, sorted_list);
+ALIST_SORT(uint32_t, sorted_list, REVERSE_CMP);
+
+HEAP_PROTO(uint32_t, heap2);
+HEAP(uint32_t, heap2, CMP, 2);
+
+HEAP_PROTO(uint32_t, heap4);
+HEAP(uint32_t, heap4, CMP, 4);
+
+uint32_t rng_state = 2463534242u;
+
+/* xorshift32, rand() only gives 15 bits on some platforms */
+uint32_t rng(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+double seconds(clock_t start)
+{
+	return (clock() - start) * 1.0 / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+	sorted_list *list;
+	heap2 *h2;
+	heap4 *h4;
+	uint32_t *init, *delays;
+	uint32_t min, sum, expected;
+	int len, ops, i, failed;
+	clock_t start;
+
+	len = argc > 1 ? atoi(argv[1]) : LEN;
+	ops = argc > 2 ? atoi(argv[2]) : OPS;
+	if (len < 1 || ops < 0) {
+		fprintf(stderr, "usage: %s [len] [ops]\n", argv[0]);
+		return 1;
+	}
+	list = sorted_list_new_cap(len + 1);
+	h2 = heap2_new_cap(len + 1);
+	h4 = heap4_new_cap(len + 1);
+	init = malloc(len * sizeof(uint32_t));
+	delays = malloc((ops > 0 ? ops : 1) * sizeof(uint32_t));
+	if (!list || !h2 || !h4 || !init || !delays) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	/* the same elements and delays for all queues, the delays up to twice the initial range */
+	for (i=0; i<len; ++i) {
+		init[i] = rng() % (1u << 20);
+	}
+	for (i=0; i<ops; ++i) {
+		delays[i] = rng() % (1u << 21);
+	}
+
+	printf("%d elements, %d pops and pushes\n", len, ops);
+
+	/* the sums check that all queues pop the same elements */
+	start = clock();
+	for (i=0; i<len; ++i) {
+		sorted_list_insert(list, init[i], sorted_list_lower_bound(list, init[i]));
+	}
+	sum = 0;
+	for (i=0; i<ops; ++i) {
+		min = sorted_list_pop(list, -1);
+		sum += min;
+		min += delays[i];
+		sorted_list_insert(list, min, sorted_list_lower_bound(list, min));
+	}
+	printf("%-22s %8.3f s (%u)\n", "sorted alist", seconds(start), sum);
+	expected = sum;
+	failed = 0;
+
+	start = clock();
+	for (i=0; i<len; ++i) {
+		heap2_push(h2, init[i]);
+	}
+	sum = 0;
+	for (i=0; i<ops; ++i) {
+		min = heap2_pop(h2);
+		sum += min;
+		heap2_push(h2, min + delays[i]);
+	}
+	printf("%-22s %8.3f s (%u)\n", "binary heap", seconds(start), sum);
+	failed |= sum != expected;
+
+	start = clock();
+	for (i=0; i<len; ++i) {
+		heap4_push(h4, init[i]);
+	}
+	sum = 0;
+	for (i=0; i<ops; ++i) {
+		min = heap4_pop(h4);
+		sum += min;
+		heap4_push(h4, min + delays[i]);
+	}
+	printf("%-22s %8.3f s (%u)\n", "4-ary heap", seconds(start), sum);
+	failed |= sum != expected;
+
+	start = clock();
+	heap4_heapify_from_array(h4, init, len);
+	printf("%-22s %8.3f s\n", "4-ary heapify", seconds(start));
+
+	free(delays);
+	free(init);
+	sorted_list_free(list);
+	heap2_free(h2);
+	heap4_free(h4);
+
+	if (failed) {
+		fprintf(stderr, "the queues popped different elements\n");
+	}
+	return failed;
+}
@@ -0,0 +1,100 @@
+/*
+ * A timer queue: a 4-ary heap of pointers to timers ordered by their
+ * deadlines, which keep their positions in the heap so they can be
+ * rescheduled and cancelled. Checks the positions after each step.
+ */
+
+#include <stdio.h>
+#include "heap.h"
+
+typedef struct timer {
+	unsigned long deadline;
+	int pos; /* in the heap, -1 if not in it */
+	int id;
+} timer;
+
+#define TIMER_CMP(a, b) ((a)->deadline < (b)->deadline ? -1 : (a)->deadline > (b)->deadline)
+#define TIMER_MOVED(item, p) ((item)->pos = (p))
+
+HEAP_PROTO(timer *, timer_queue);
+HEAP_TRACKED(timer *, timer_queue, TIMER_CMP, 4, TIMER_MOVED);
+
+/* returns 1 if every timer in the queue knows its position and is not earlier than its parent */
+int check(const timer_queue *q, int len)
+{
+	int i;
+
+	if (timer_queue_size(q) != len) return 0;
+	for (i=0; i<len; ++i) {
+		if (q->arr[i]->pos != i) return 0;
+		if (i > 0 && TIMER_CMP(q->arr[i], q->arr[(i - 1) / 4]) < 0) return 0;
+	}
+	return 1;
+}
+
+/* pops all timers and returns 1 if their ids are expected[0], ..., expected[len-1] */
+int check_order(timer_queue *q, const int *expected, int len)
+{
+	timer *t;
+	int i;
+
+	for (i=0; i<len; ++i) {
+		t = timer_queue_pop(q);
+		printf(" %d:%lu", t->id, t->deadline);
+		if (t->id != expected[i] || t->pos != -1 || !check(q, len - i - 1)) {
+			printf(" (wrong)\n");
+			return 0;
+		}
+	}
+	printf("\n");
+	return 1;
+}
+
+int main(void)
+{
+	timer_queue *q;
+	timer timers[10];
+	timer *all[10];
+	timer *t;
+	static const unsigned long deadlines[] = {50, 20, 90, 10, 70, 30, 80, 60, 40, 100};
+	/* after moving timer 6 to 5 and cancelling timer 4 */
+	static const int expected[] = {6, 3, 1, 5, 8, 0, 7, 2, 9};
+	/* the ids of all timers ordered by their deadlines */
+	static const int sorted[] = {3, 1, 5, 8, 0, 7, 4, 6, 2, 9};
+	int i;
+
+	q = timer_queue_new();
+	if (!q) return 1;
+	for (i=0; i<10; ++i) {
+		timers[i].deadline = deadlines[i];
+		timers[i].pos = -1;
+		timers[i].id = i;
+		all[i] = &timers[i];
+		if (!timer_queue_push(q, &timers[i])) return 1;
+		if (!check(q, i + 1)) return 1;
+	}
+	if (timer_queue_peek(q) != &timers[3]) return 1;
+
+	/* reschedule timer 6 earlier than all others, it moves to the root */
+	timers[6].deadline = 5;
+	timer_queue_decrease_key(q, timers[6].pos, &timers[6]);
+	if (timers[6].pos != 0 || !check(q, 10)) return 1;
+
+	/* cancel timer 4, wherever it is */
+	t = timer_queue_remove(q, timers[4].pos);
+	if (t != &timers[4] || t->pos != -1 || !check(q, 9)) return 1;
+
+	printf("pop:");
+	if (!check_order(q, expected, 9)) return 1;
+
+	/* build the queue from an array at once; the deadlines are back to the start */
+	timers[6].deadline = deadlines[6];
+	if (!timer_queue_heapify_from_array(q, all, 10)) return 1;
+	if (!check(q, 10)) return 1;
+	printf("heapify:");
+	if (!check_order(q, sorted, 10)) return 1;
+
+	timer_queue_free(q);
+
+	return 0;
+}
@@ -86,7 +86,7 @@ T randt(void)
 	return t;
 }
 
-stats map_stats(const map *m)
+stats layout_stats(const map *m)
 {
 	stats s;
 	map_bucket *b;
@@ -153,19 +153,19 @@ int main(void)
 		m->max_load = *max_load;
 		++max_load;
 		lastcap = m->cap;
-		s = map_stats(m);
+		s = layout_stats(m);
 		srand(0);
 		for (i=0; i<=N; ++i) {
 			while (m->cap == lastcap) {
 				if ((m->len+1.0)/m->cap > m->max_load) {
-					s = map_stats(m);
+					s = layout_stats(m);
 				}
 				map_set(m, randt(), randt());
 			}
 			lastcap = m->cap;
 		}
 		stat_list_insert(l1, s, -1);
-		stat_list_insert(l2, map_stats(m), -1);
+		stat_list_insert(l2, layout_stats(m), -1);
 		map_free(m);
 	}
 
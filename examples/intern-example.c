@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include "intern.h"
+
+/*
+ * A map from strings to word counts named words. Its keys are copied into an
+ * arena owned by the map, so the strings passed to it don't need to be kept
+ * around or null-terminated.
+ */
+INTERN_PROTO(int, words);
+INTERN(int, words);
+
+int main(void)
+{
+	const char *text = "the quick brown fox jumps over the lazy dog the end";
+	const char *start, *end, *fox;
+	words *w;
+	words_iterator i;
+
+	w = words_new();
+
+	/* count the words of the text without copying them out of it first */
+	for (start=text; *start; start=end) {
+		for (end=start; *end && *end != ' '; ++end);
+		/*
+		 * `int *words_upsert(words *w, const char *str, size_t len, int *inserted)`
+		 * works like upsert in hmap, new strings are copied to the arena.
+		 */
+		++*words_upsert(w, start, end-start, NULL);
+		if (*end) ++end;
+	}
+
+	/*
+	 * `const char *words_intern(words *w, const char *str, size_t len)` returns
+	 * the copy of the string in the arena, adding it first if necessary. The
+	 * same string always gives the same pointer, so interned strings can be
+	 * compared with ==. The length of an interned string is stored with it.
+	 */
+	fox = words_intern(w, "fox", 3);
+	printf("%s (%lu) interned once: %s\n", fox, (unsigned long)words_strlen(fox),
+			fox == words_intern(w, text+16, 3) ? "yes" : "no"); /* fox (3) interned once: yes */
+
+	/* words (size: 9) { the:3, fox:1, ... }; note: undefined order */
+	printf("words (size: %d) {", words_size(w));
+	for (i=words_iterate(w); words_next(w, &i); ) {
+		printf(" %s:%d,", words_key_at(w, i), words_value_at(w, i));
+	}
+	printf("\b }\n");
+
+	/* frees the map and all interned strings at once */
+	words_free(w);
+
+	return 0;
+}
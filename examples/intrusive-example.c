@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include "ilist.h"
+#include "itree.h"
+
+/*
+ * Intrusive containers don't allocate nodes holding copies of the elements,
+ * the links are fields of the elements themselves. An element can be in as
+ * many lists and trees at once as it has link fields, and linking and
+ * unlinking it never fails, so the elements can live anywhere: in an array
+ * like here, in a pool or in malloc'ed memory owned by something else.
+ */
+typedef struct conn {
+	int id;
+	int idle;
+	/* the links of the list of all connections */
+	ilist_link all;
+	/* the links of the list of idle connections */
+	ilist_link idle_link;
+	/* the links of the tree of connections ordered by id */
+	itree_link by_id;
+} conn;
+
+/* the tree compares elements through pointers; this can be a macro or a function */
+#define conn_cmp(a, b) ((a)->id < (b)->id ? -1 : (a)->id > (b)->id)
+
+/* a list type for each link field, named after the lists */
+ILIST_PROTO(conn, conn_list);
+ILIST(conn, all, conn_list);
+ILIST_PROTO(conn, idle_list);
+ILIST(conn, idle_link, idle_list);
+ITREE_PROTO(conn, conn_tree);
+ITREE(conn, by_id, conn_tree, conn_cmp);
+
+int main(void)
+{
+	conn conns[6];
+	conn_list all;
+	idle_list idle;
+	conn_tree by_id;
+	conn key, *c;
+	conn_list_iterator i;
+	conn_tree_iterator t;
+	int k;
+
+	/* lists and trees don't own any memory, so there's only init */
+	conn_list_init(&all);
+	idle_list_init(&idle);
+	conn_tree_init(&by_id);
+
+	for (k=0; k<6; ++k) {
+		conns[k].id = (k * 5) % 6 * 10 + 5;
+		conns[k].idle = k % 2;
+		/* NULL links to the tail, an element links before it */
+		conn_list_link(&all, &conns[k], NULL);
+		if (conns[k].idle) idle_list_link(&idle, &conns[k], NULL);
+		/* insert returns an element with the same id if there's one */
+		conn_tree_insert(&by_id, &conns[k]);
+	}
+
+	/* iterating works like with other lists, the iterator is the element */
+	printf("all:");
+	for (i=conn_list_iterate(&all); conn_list_next(&all, &i); ) {
+		printf(" %d", conn_list_get_at(&all, i)->id);
+	}
+	printf("\nby id:");
+	for (t=conn_tree_iterate(&by_id); conn_tree_next(&by_id, &t); ) {
+		printf(" %d", t->id);
+	}
+	printf("\n");
+
+	/* lookups take an element with the fields compared by conn_cmp */
+	key.id = 30;
+	c = conn_tree_lower_bound(&by_id, &key);
+	printf("first id >= %d: %d\n", key.id, c ? c->id : -1);
+
+	/* close the idle connections: unlinking from one list leaves the others alone */
+	while ((c = idle_list_pop(&idle, 0))) {
+		printf("closing %d\n", c->id);
+		conn_list_unlink(&all, c);
+		conn_tree_remove(&by_id, c);
+	}
+
+	printf("%d left:", (int)conn_tree_size(&by_id));
+	for (t=conn_tree_iterate(&by_id); conn_tree_prev(&by_id, &t); ) {
+		printf(" %d", t->id);
+	}
+	printf("\n");
+
+	return 0;
+}
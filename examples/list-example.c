@@ -1,11 +1,13 @@
 #include <stdio.h>
+#include <string.h>
 #include "alist.h"
 #include "llist.h"
 
 /*
  * All examples in here can be used with both array and linked lists. To use
  * arraylists instead of linked lists, change LLIST_PROTO and LLIST to
- * ALIST_PROTO and ALIST, respectively.
+ * ALIST_PROTO and ALIST, respectively (or DLIST_PROTO and DLIST for
+ * doubly-linked lists, after including dlist.h).
  *
  * The examples use a list of integers named int_list. The list name and the
  * type of its elements are arbitrary. The name of supplementary types and
@@ -20,6 +22,206 @@ LLIST_PROTO(int, int_list);
 /* create functions for our list, this goes in a .c file */
 LLIST(int, int_list);
 
+/* a plain alist, to show popping from its tail and lists without any capacity */
+ALIST_PROTO(int, array_list);
+ALIST(int, array_list);
+
+/* pops from the tail with position -1 until the list is empty */
+int tail_pop_example(void)
+{
+	array_list *list;
+	int i;
+
+	list = array_list_new();
+	if (!list) return 0;
+	for (i = 0; i < 3; ++i) {
+		if (!array_list_insert(list, i, -1)) {
+			array_list_free(list);
+			return 0;
+		}
+	}
+	/* each pop removes the last element, like a pop on array_list_size(list)-1 */
+	for (i = 2; i >= 0; --i) {
+		if (array_list_pop(list, -1) != i || array_list_size(list) != i) {
+			array_list_free(list);
+			return 0;
+		}
+	}
+	printf("popped 3 elements from the tail\n");
+	array_list_free(list);
+	return 1;
+}
+
+/*
+ * An alist of doubles whose array always starts at a multiple of 64 bytes (a
+ * cache line), e.g. for aligned SIMD loads. It has the same functions as an
+ * alist made with ALIST, so it uses ALIST_PROTO.
+ */
+ALIST_PROTO(double, aligned_list);
+ALIST_ALIGNED(double, aligned_list, 64);
+
+/*
+ * An alist which keeps up to 4 elements inside its struct and only allocates
+ * an array once it grows past that, e.g. for lists that are usually short.
+ */
+SMALL_ALIST_PROTO(int, small_list);
+SMALL_ALIST(int, small_list, 4);
+
+/*
+ * An alist of strings with the sorting and searching functions, ordered by
+ * strcmp; the searches take a string to look for like the other functions.
+ */
+ALIST_PROTO(char *, string_list);
+ALIST(char *, string_list);
+ALIST_SORT_PROTO(char *, string_list);
+ALIST_SORT(char *, string_list, strcmp);
+
+/* grows and shrinks an aligned list, checking that its array stays aligned */
+int aligned_list_example(void)
+{
+	aligned_list *list;
+	int i;
+
+	list = aligned_list_new();
+	if (!list) return 0;
+	for (i = 0; i < 1000; ++i) {
+		/* every growth may move the array, which is realigned when it moves */
+		if (!aligned_list_insert(list, i * 0.5, -1) || (uintptr_t)list->arr % 64 != 0) {
+			aligned_list_free(list);
+			return 0;
+		}
+	}
+	/* shrinking keeps the first 10 elements and the alignment */
+	if (!aligned_list_resize(list, 10) || (uintptr_t)list->arr % 64 != 0 || aligned_list_get(list, -1) != 4.5) {
+		aligned_list_free(list);
+		return 0;
+	}
+	printf("aligned list: %d elements at a multiple of 64\n", aligned_list_size(list));
+	aligned_list_free(list);
+	return 1;
+}
+
+/* moves a small list from its inline elements to an array and back */
+int small_list_example(void)
+{
+	/* a small list in a local variable doesn't allocate while it's short */
+	small_list list;
+	int i;
+
+	if (!small_list_init(&list)) return 0;
+	for (i = 0; i < 4; ++i) small_list_insert(&list, i, -1);
+	if (list.arr != list.inline_arr) return 0;
+
+	/* the fifth element moves them all to a malloc'd array */
+	if (!small_list_insert(&list, 4, -1) || list.arr == list.inline_arr) {
+		small_list_destroy(&list);
+		return 0;
+	}
+	for (i = 5; i < 100; ++i) {
+		if (!small_list_insert(&list, i, -1)) {
+			small_list_destroy(&list);
+			return 0;
+		}
+	}
+
+	/* shrinking back to 4 elements moves them inline and frees the array */
+	if (!small_list_resize(&list, 4) || list.arr != list.inline_arr || small_list_get(&list, -1) != 3) {
+		small_list_destroy(&list);
+		return 0;
+	}
+	printf("small list: %d elements inline\n", small_list_size(&list));
+	small_list_destroy(&list);
+	return 1;
+}
+
+/* an alist can start without capacity or lose it all, inserting grows it again */
+int empty_list_example(void)
+{
+	array_list *list;
+	int i;
+
+	list = array_list_new_cap(0);
+	if (!list) return 0;
+	for (i = 0; i < 3; ++i) {
+		if (!array_list_insert(list, i, -1)) {
+			array_list_free(list);
+			return 0;
+		}
+	}
+	/* resize to 0 drops all elements, shrink_to_fit keeps room for one */
+	if (!array_list_resize(list, 0) || array_list_size(list) != 0 || !array_list_insert(list, 10, -1)) {
+		array_list_free(list);
+		return 0;
+	}
+	list->len = 0;
+	if (!array_list_shrink_to_fit(list) || !array_list_insert(list, 20, 0) || !array_list_insert(list, 30, -1)
+			|| array_list_get(list, 0) != 20 || array_list_get(list, 1) != 30) {
+		array_list_free(list);
+		return 0;
+	}
+	printf("empty list grown to %d elements\n", array_list_size(list));
+	array_list_free(list);
+	return 1;
+}
+
+/* sorts a list of strings and finds them by binary and Eytzinger search */
+int string_sort_example(void)
+{
+	static char *words[] = {
+		"pear", "fig", "apple", "quince", "kiwi", "lime", "date", "plum", "mango", "cherry",
+		"grape", "lemon", "melon", "olive", "peach", "banana", "guava", "papaya", "nut", "yam"
+	};
+	static char *missing[] = {"aaa", "carrot", "mangoes", "zucchini"};
+	string_list *list;
+	char **eyt;
+	int i, n, k, lb, ok;
+
+	n = sizeof(words) / sizeof(words[0]);
+	list = string_list_new();
+	if (!list) return 0;
+	for (i = 0; i < n; ++i) {
+		if (!string_list_insert(list, words[i], -1)) {
+			string_list_free(list);
+			return 0;
+		}
+	}
+	/* more elements than ALIST_SORT_THRESHOLD, so the introsort partitions them */
+	string_list_sort(list);
+	for (i = 1; i < n; ++i) {
+		if (strcmp(string_list_get(list, i-1), string_list_get(list, i)) >= 0) {
+			string_list_free(list);
+			return 0;
+		}
+	}
+	eyt = string_list_eytzinger(list);
+	if (!eyt) {
+		string_list_free(list);
+		return 0;
+	}
+	/*
+	 * every word is found where it is; the Eytzinger search returns a position
+	 * in eyt (0 for none), which holds the same string as the list at the
+	 * lower bound
+	 */
+	ok = 1;
+	for (i = 0; i < n; ++i) {
+		k = string_list_eytzinger_search(eyt, n, words[i]);
+		ok = ok && string_list_get(list, string_list_binary_search(list, words[i])) == words[i]
+			&& k != 0 && eyt[k] == words[i];
+	}
+	for (i = 0; i < 4; ++i) {
+		k = string_list_eytzinger_search(eyt, n, missing[i]);
+		lb = string_list_lower_bound(list, missing[i]);
+		ok = ok && string_list_binary_search(list, missing[i]) == -1
+			&& (lb == n ? k == 0 : k != 0 && eyt[k] == string_list_get(list, lb));
+	}
+	free(eyt);
+	printf("sorted strings: %s ... %s, \"mangoes\" goes before %s\n", string_list_get(list, 0),
+		string_list_get(list, -1), string_list_get(list, string_list_lower_bound(list, "mangoes")));
+	string_list_free(list);
+	return ok;
+}
+
 /* a helper function to print a list and demonstrate iterating */
 void print_list(int_list *list)
 {
@@ -110,8 +312,9 @@ int main(void)
 	 *
 	 * Position -1 again means position int_list_size(list).
 	 *
-	 * In llist, this is an O(n) operation except for pos 0 or -1, since the
-	 * list needs to be iterated to pos. In alist, this is also O(n), since all
+	 * In llist, this is an O(n) operation except for pos 0, since the list
+	 * needs to be iterated to pos (to the element before the last one for -1;
+	 * dlist pops on both ends in O(1)). In alist, this is also O(n), since all
 	 * elements past position pos need to be shifted back (except on position -1
 	 * or int_list_size(list), where it's O(1), as it requires only list->len to
 	 * be decremented).
@@ -136,5 +339,11 @@ int main(void)
 	/* the list can't just be free'd with free(), as it contains other pointers */
 	int_list_free(list);
 
+	if (!aligned_list_example()) return 1;
+	if (!small_list_example()) return 1;
+	if (!empty_list_example()) return 1;
+	if (!tail_pop_example()) return 1;
+	if (!string_sort_example()) return 1;
+
 	return 0;
 }
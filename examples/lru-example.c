@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include "lru.h"
+
+uint32_t djb2(const char *str);
+
+/*
+ * A cache of at most 3 entries mapping strings to ints named cache. The
+ * comparison and hash functions are the same as in HMAP, see map-example.c;
+ * the last parameter is the capacity. CLOCK_CACHE_PROTO and CLOCK_CACHE
+ * define a cache with the same functions, which evicts with CLOCK instead.
+ */
+LRU_CACHE_PROTO(char *, int, cache);
+LRU_CACHE(char *, int, cache, strcmp, djb2, 3);
+
+/* a nice string hashing function, see http://www.cse.yorku.ca/~oz/hash.html */
+uint32_t djb2(const char *str)
+{
+	uint32_t hash = 5381;
+	int c;
+	while ((c = *str++)) {
+		hash = ((hash << 5) + hash) + c;
+	}
+	return hash;
+}
+
+/* called with each evicted entry and the evict_ctx of the cache */
+void evicted(char *key, int value, void *ctx)
+{
+	printf("%s: evicted %s:%d\n", (char *)ctx, key, value);
+}
+
+void print_cache(cache *c)
+{
+	cache_iterator i;
+
+	printf("cache (size: %d) {", cache_size(c));
+	for (i=cache_iterate(c); cache_next(c, &i); ) {
+		printf(" %s:%d,", cache_key_at(c, i), cache_value_at(c, i));
+	}
+	printf("\b }\n");
+}
+
+int main(void)
+{
+	cache *c;
+	int value;
+
+	/* all the memory of the cache is allocated here */
+	c = cache_new();
+	c->on_evict = evicted;
+	c->evict_ctx = "example";
+
+	cache_put(c, "one", 1);
+	cache_put(c, "two", 2);
+	cache_put(c, "three", 3);
+
+	/* iteration goes from the most to the least recently used entry */
+	print_cache(c); /* cache (size: 3) { three:3, two:2, one:1 } */
+
+	/* `int cache_get(cache *c, char *key, int *value)` makes "one" the most recently used */
+	cache_get(c, "one", &value);
+
+	/* `int cache_peek(const cache *c, char *key, int *value)` doesn't */
+	cache_peek(c, "two", &value);
+
+	/*
+	 * `int cache_put(cache *c, char *key, int value)` evicts the least recently
+	 * used entry when the cache is full, returns 1 if it did
+	 */
+	cache_put(c, "four", 4); /* example: evicted two:2 */
+	print_cache(c); /* cache (size: 3) { four:4, one:1, three:3 } */
+
+	cache_free(c);
+
+	return 0;
+}
@@ -1,7 +1,14 @@
 #include <stdio.h>
+
+/*
+ * Make every map in this file count what its operations do, see map_stats
+ * below. Without it, the counting code isn't compiled at all.
+ */
+#define HMAP_STATS
 #include "hmap.h"
 
 uint32_t djb2(const char *str);
+uint32_t djb2_view(hmap_strview key);
 
 /* 
  * Create prototypes, structs and typedefs for a map with string keys and
@@ -35,6 +42,20 @@ HMAP_PROTO(char *, int, map);
  */
 HMAP(char *, int, map, strcmp, djb2);
 
+/*
+ * A map with hmap_strview keys, strings with their length. hmap_strview_cmp
+ * only compares strings of the same length and doesn't need them to be
+ * null-terminated.
+ */
+HMAP_PROTO(hmap_strview, int, view_map);
+HMAP(hmap_strview, int, view_map, hmap_strview_cmp, djb2_view);
+
+/* a map with pointer values, from error codes to their names */
+int code_cmp(int a, int b);
+uint32_t code_hash(int code);
+HMAP_PROTO(int, char *, code_map);
+HMAP(int, char *, code_map, code_cmp, code_hash);
+
 /* a nice string hashing function, see http://www.cse.yorku.ca/~oz/hash.html */
 uint32_t djb2(const char *str)
 {
@@ -46,6 +67,27 @@ uint32_t djb2(const char *str)
 	return hash;
 }
 
+/* djb2 for strings with a length */
+uint32_t djb2_view(hmap_strview key)
+{
+	uint32_t hash = 5381;
+	size_t i;
+	for (i=0; i<key.len; ++i) {
+		hash = ((hash << 5) + hash) + (unsigned char)key.str[i];
+	}
+	return hash;
+}
+
+int code_cmp(int a, int b)
+{
+	return (a > b) - (a < b);
+}
+
+uint32_t code_hash(int code)
+{
+	return (uint32_t)code * 2654435761u;
+}
+
 /* a function that prints out the contents of the map */
 void print_map(map *m)
 {
@@ -66,6 +108,12 @@ void print_map(map *m)
 int main(void)
 {
 	map *m;
+	view_map *vm;
+	code_map *cm;
+	char *name;
+	hmap_stats stats;
+	hmap_strview key;
+	uint32_t hash;
 	int contains;
 	int value;
 
@@ -140,8 +188,77 @@ int main(void)
 
 	print_map(m); /* map (size: 3) { foo:1, bar:2, baz:3 } */
 
+	/*
+	 * `int *map_upsert(map *m, char *key, int *inserted)` returns a pointer to
+	 * the value of `key`, adding an entry with a zeroed value first if there's
+	 * none (and setting `*inserted` to 1 in that case, 0 otherwise). Unlike
+	 * map_get followed by map_set, this hashes and looks up the key just once.
+	 * The pointer is valid until the next map_set, map_upsert or map_delete.
+	 */
+	++*map_upsert(m, "foo", NULL);
+	++*map_upsert(m, "qwe", NULL);
+
+	/*
+	 * `int *map_get_ref(map *m, char *key)` is the same, but returns NULL if
+	 * there's no such key.
+	 */
+	printf("foo: %d, qwe: %d\n", *map_get_ref(m, "foo"), *map_get_ref(m, "qwe")); /* foo: 2, qwe: 1 */
+
+	/*
+	 * `int map_take(map *m, char *key, int *value)` deletes the entry like
+	 * map_delete, but also stores its value to `*value`.
+	 */
+	if (map_take(m, "qwe", &value)) {
+		printf("took qwe: %d\n", value); /* took qwe: 1 */
+	}
+
+	/* `int map_resize(map *m, int cap)` changes the number of buckets */
+	map_resize(m, 64);
+
+	/*
+	 * `void map_stats(const map *m, hmap_stats *stats)` copies the counters of
+	 * the map, e.g. to check how many entries lookups compare on average;
+	 * `map_stats_reset` zeroes them.
+	 */
+	map_stats(m, &stats);
+	printf("%lu lookups, %lu hits, %lu compares, %lu resize, %lu bytes\n",
+			stats.lookups, stats.hits, stats.compares, stats.resizes, stats.bytes);
+	if (stats.resizes != 1 || stats.hits + stats.misses != stats.lookups) return 1;
+
 	/* `void map_free(map *m)` frees the map and its resources */
 	map_free(m);
 
+	vm = view_map_new();
+
+	/* the key is the first 3 characters of a longer string */
+	key.str = "foobar";
+	key.len = 3;
+
+	/*
+	 * When the hash of a key is already known, e.g. because it was used to pick
+	 * a shard or a log file, `view_map_set_hashed`, `view_map_get_hashed` and
+	 * `view_map_delete_hashed` take it as a parameter instead of calling the
+	 * hash function. It must be the same as the hash function would return.
+	 */
+	hash = djb2_view(key);
+	view_map_set_hashed(vm, key, hash, 1);
+	contains = view_map_get_hashed(vm, key, hash, &value);
+	printf("foo in view_map: %s, value: %d\n", contains?"yes":"no", value); /* foo in view_map: yes, value: 1 */
+	view_map_delete_hashed(vm, key, hash);
+
+	view_map_free(vm);
+
+	/* values can be pointers too; a missing key gets a NULL value */
+	cm = code_map_new();
+	code_map_set(cm, 404, "not found");
+	code_map_set(cm, 500, "server error");
+	*code_map_upsert(cm, 418, &contains) = "teapot";
+	if (!contains || code_map_size(cm) != 3) return 1;
+	if (!code_map_get_contains(cm, 500, &name) || strcmp(name, "server error")) return 1;
+	if (strcmp(code_map_get(cm, 418), "teapot") || code_map_get(cm, 200) != NULL) return 1;
+	code_map_upsert(cm, 404, &contains);
+	if (contains || strcmp(code_map_get(cm, 404), "not found")) return 1;
+	code_map_free(cm);
+
 	return 0;
 }
@@ -0,0 +1,137 @@
+/*
+ * Measures the throughput of the ALIST_NUMERIC bulk operations in elements
+ * per nanosecond, next to the naive loops over list->arr they replace.
+ *
+ * gcc -O3 -march=native -I.. numeric-benchmark.c -o numeric-benchmark && ./numeric-benchmark
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "alist.h"
+
+#define LEN 4000000 /* elements per list */
+#define REPEAT 50 /* passes over the list per operation */
+
+ALIST_PROTO(uint32_t, u32_list);
+ALIST(uint32_t, u32_list);
+ALIST_NUMERIC_PROTO(uint32_t, u32_list);
+ALIST_NUMERIC(uint32_t, u32_list);
+
+/* aligned to a cache line, so vector loads never straddle two */
+ALIST_PROTO(float, float_list);
+ALIST_ALIGNED(float, float_list, 64);
+ALIST_NUMERIC_PROTO(float, float_list);
+ALIST_NUMERIC(float, float_list);
+
+/* keeps the results alive, so the loops aren't optimized out */
+volatile double sink;
+
+void report(const char *name, clock_t start)
+{
+	double ns;
+	ns = (clock() - start) * 1e9 / CLOCKS_PER_SEC;
+	printf("%-22s %6.2f elements/ns\n", name, LEN * 1.0 * REPEAT / (ns > 0 ? ns : 1));
+}
+
+/* the naive loops */
+
+int naive_find(const u32_list *s, uint32_t value)
+{
+	int i;
+	for (i=0; i<s->len; ++i) {
+		if (s->arr[i] == value) return i;
+	}
+	return -1;
+}
+
+uint32_t naive_max(const u32_list *s)
+{
+	uint32_t max;
+	int i;
+	max = s->arr[0];
+	for (i=1; i<s->len; ++i) {
+		if (s->arr[i] > max) max = s->arr[i];
+	}
+	return max;
+}
+
+float naive_sum(const float_list *s)
+{
+	float sum;
+	int i;
+	sum = 0;
+	for (i=0; i<s->len; ++i) sum += s->arr[i];
+	return sum;
+}
+
+int main(void)
+{
+	u32_list *u, *out;
+	float_list *f;
+	clock_t start;
+	int i, r;
+
+	u = u32_list_new_cap(LEN);
+	out = u32_list_new_cap(LEN);
+	f = float_list_new_cap(LEN);
+	if (!u || !out || !f) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	srand(0);
+	for (i=0; i<LEN; ++i) {
+		u32_list_insert(u, rand() % 1000, -1);
+		float_list_insert(f, rand() * 1.0f / RAND_MAX, -1);
+	}
+
+	start = clock();
+	for (r=0; r<REPEAT; ++r) sink = naive_find(u, 1000 + r);
+	report("naive find (miss)", start);
+	start = clock();
+	for (r=0; r<REPEAT; ++r) sink = u32_list_find(u, 1000 + r);
+	report("u32_list_find (miss)", start);
+
+	start = clock();
+	for (r=0; r<REPEAT; ++r) sink = u32_list_count(u, r);
+	report("u32_list_count", start);
+
+	start = clock();
+	for (r=0; r<REPEAT; ++r) sink = naive_max(u);
+	report("naive max", start);
+	start = clock();
+	for (r=0; r<REPEAT; ++r) sink = u32_list_max(u);
+	report("u32_list_max", start);
+
+	start = clock();
+	for (r=0; r<REPEAT; ++r) sink = u32_list_sum(u);
+	report("u32_list_sum", start);
+
+	start = clock();
+	for (r=0; r<REPEAT; ++r) sink = naive_sum(f);
+	report("naive float sum", start);
+	start = clock();
+	for (r=0; r<REPEAT; ++r) sink = float_list_sum(f);
+	report("float_list_sum", start);
+
+	start = clock();
+	for (r=0; r<REPEAT; ++r) {
+		out->len = 0;
+		u32_list_filter_into(u, out, 0, 499);
+	}
+	sink = out->len;
+	report("u32_list_filter_into", start);
+
+	start = clock();
+	for (r=0; r<REPEAT; ++r) u32_list_fill(u, r);
+	report("u32_list_fill", start);
+
+	start = clock();
+	for (r=0; r<REPEAT; ++r) u32_list_prefix_sum(u);
+	report("u32_list_prefix_sum", start);
+
+	u32_list_free(u);
+	u32_list_free(out);
+	float_list_free(f);
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include "ohmap.h"
+
+uint32_t djb2(const char *str);
+
+/*
+ * An insertion-ordered map is declared like a map from hmap.h, see
+ * map-example.c. It has the same functions, so one can replace the other.
+ */
+HMAP_ORDERED_PROTO(char *, int, omap);
+HMAP_ORDERED(char *, int, omap, strcmp, djb2);
+
+/* an ordered map with pointer values, from the position of a word to it */
+int pos_cmp(int a, int b);
+uint32_t pos_hash(int pos);
+HMAP_ORDERED_PROTO(int, char *, word_map);
+HMAP_ORDERED(int, char *, word_map, pos_cmp, pos_hash);
+
+/* a nice string hashing function, see http://www.cse.yorku.ca/~oz/hash.html */
+uint32_t djb2(const char *str)
+{
+	uint32_t hash = 5381;
+	int c;
+	while ((c = *str++)) {
+		hash = ((hash << 5) + hash) + c;
+	}
+	return hash;
+}
+
+int pos_cmp(int a, int b)
+{
+	return (a > b) - (a < b);
+}
+
+uint32_t pos_hash(int pos)
+{
+	return (uint32_t)pos * 2654435761u;
+}
+
+/* iteration goes through the entries in the order they were added */
+void print_map(omap *m)
+{
+	omap_iterator i;
+
+	printf("map (size: %d) {", omap_size(m));
+	for (i=omap_iterate(m); omap_next(m, &i); ) {
+		printf(" %s:%d,", omap_key_at(m, i), omap_value_at(m, i));
+	}
+	printf("\b }\n");
+}
+
+int main(void)
+{
+	omap *m;
+	word_map *w;
+	word_map_iterator i;
+	int inserted;
+
+	m = omap_new();
+
+	omap_set(m, "one", 1);
+	omap_set(m, "two", 2);
+	omap_set(m, "three", 3);
+	omap_set(m, "four", 4);
+
+	/* setting an existing key keeps its position */
+	omap_set(m, "one", 11);
+	print_map(m); /* map (size: 4) { one:11, two:2, three:3, four:4 } */
+
+	/* a deleted key is added again at the end */
+	omap_delete(m, "two");
+	omap_set(m, "two", 22);
+	print_map(m); /* map (size: 4) { one:11, three:3, four:4, two:22 } */
+
+	/*
+	 * Deleted entries stay in the entry array until it's full or
+	 * `int omap_compact(omap *m)` is called, which also shrinks the map to
+	 * the capacity it needs. It returns 0 on malloc failure.
+	 */
+	omap_delete(m, "three");
+	omap_compact(m);
+	print_map(m); /* map (size: 3) { one:11, four:4, two:22 } */
+
+	omap_free(m);
+
+	w = word_map_new();
+	word_map_set(w, 3, "three");
+	word_map_set(w, 1, "one");
+	*word_map_upsert(w, 2, &inserted) = "two";
+	if (!inserted || word_map_get(w, 4) != NULL) return 1;
+	i = word_map_iterate(w);
+	if (!word_map_next(w, &i) || strcmp(word_map_value_at(w, i), "three")) return 1;
+	word_map_upsert(w, 1, &inserted);
+	if (inserted || strcmp(word_map_get(w, 1), "one")) return 1;
+	word_map_free(w);
+
+	return 0;
+}
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include "hset.h"
+
+uint32_t djb2(const char *str);
+
+/*
+ * A set is declared like a map without the value type. The comparison and
+ * hash functions are the same as in HMAP, see map-example.c.
+ */
+HSET_PROTO(char *, set);
+HSET(char *, set, strcmp, djb2);
+
+/* a nice string hashing function, see http://www.cse.yorku.ca/~oz/hash.html */
+uint32_t djb2(const char *str)
+{
+	uint32_t hash = 5381;
+	int c;
+	while ((c = *str++)) {
+		hash = ((hash << 5) + hash) + c;
+	}
+	return hash;
+}
+
+/* sets are iterated like maps, but there's only set_key_at */
+void print_set(const char *name, set *s)
+{
+	set_iterator i;
+
+	printf("%s (size: %d) {", name, set_size(s));
+	for (i=set_iterate(s); set_next(s, &i); ) {
+		printf(" %s,", set_key_at(s, i));
+	}
+	printf("\b }\n");
+}
+
+int main(void)
+{
+	set *a, *b, *out;
+
+	a = set_new();
+	b = set_new();
+	out = set_new();
+
+	/* `int set_add(set *s, char *key)` adds `key`, returns 0 on malloc failure */
+	set_add(a, "foo");
+	set_add(a, "bar");
+	set_add(a, "baz");
+	set_add(b, "bar");
+	set_add(b, "baz");
+	set_add(b, "quux");
+
+	/* `int set_remove(set *s, char *key)` returns 1 if `key` was removed */
+	set_remove(a, "baz");
+
+	/* `int set_contains(const set *s, char *key)` */
+	printf("baz in a: %s\n", set_contains(a, "baz")?"yes":"no"); /* baz in a: no */
+
+	print_set("a", a); /* a (size: 2) { foo, bar }; note: undefined order */
+	print_set("b", b); /* b (size: 3) { bar, baz, quux } */
+
+	/*
+	 * The set operations add their result to `out`, which may also be one of
+	 * the operands to update it in place. They reuse the hashes stored in the
+	 * sets instead of hashing the keys again.
+	 */
+	set_union_into(out, a, b);
+	print_set("a | b", out); /* a | b (size: 4) { foo, bar, baz, quux } */
+
+	set_free(out);
+	out = set_new();
+	set_intersect_into(out, a, b);
+	print_set("a & b", out); /* a & b (size: 1) { bar } */
+
+	set_difference_into(a, a, b);
+	print_set("a - b", a); /* a - b (size: 1) { foo } */
+
+	set_free(a);
+	set_free(b);
+	set_free(out);
+
+	return 0;
+}
@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "../tree.h"
+#include "../shared.h"
+
+#define THREADS 4
+
+TREE_PROTO( const char *, tree );
+
+TREE( const char *, tree );
+SHARED( tree *, stree );
+
+void free_tree( tree **t ){
+	printf( "freeing the tree\n" );
+	tree_free_all( *t );
+}
+
+/* Each thread owns a reference to the same tree, no copy is made */
+void *reader( void *arg ){
+	shared_t(stree) t = arg;
+
+	printf( "thread sees %u nodes, %u owners\n",
+			(unsigned)tree_size( *t ), (unsigned)stree_use_count( t ));
+
+	return NULL;
+}
+
+int main( int argc, char *argv[] ){
+	pthread_t threads[THREADS];
+	weak_t(stree) observer = { NULL };
+	int i;
+
+	{
+		shared_t(stree) t = stree_make_shared(
+			tree_construct( "testing",
+					tree_construct( "this",
+						tree_new( "tree tester" ),
+						tree_new( "yes, a tree tester" )),
+					tree_new( "thing" )),
+			free_tree );
+
+		if ( !t ){
+			return 1;
+		}
+
+		observer = stree_weak_ref( t );
+
+		for ( i = 0; i < THREADS; i++ ){
+			/* the thread releases the reference it's given when it returns */
+			if ( pthread_create( &threads[i], NULL, reader, stree_retain( t ))){
+				stree_release( t );
+				return 1;
+			}
+		}
+
+		/* main's reference is released at the end of this block */
+	}
+
+	for ( i = 0; i < THREADS; i++ ){
+		pthread_join( threads[i], NULL );
+	}
+
+	{
+		/* all owners are gone, so the weak reference can't be locked */
+		shared_t(stree) t = stree_lock( observer );
+
+		printf( "tree is %s\n", t ? "still alive" : "gone" );
+	}
+
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Compares qsort with the sorts and searches generated by ALIST_SORT and
+ * ALIST_RADIX_SORT on an array list of random 32-bit integers.
+ *
+ * gcc -O2 -I.. sort-benchmark.c -o sort-benchmark && ./sort-benchmark [len]
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include "alist.h"
+
+#define LEN 10000000 /* default number of elements */
+#define LOOKUPS 1000000 /* number of searches */
+
+#define CMP(a, b) ((a) < (b) ? -1 : (a) > (b))
+#define KEY(a) (a)
+
+ALIST_PROTO(uint32_t, intro_list);
+ALIST(uint32_t, intro_list);
+ALIST_SORT_PROTO(uint32_t, intro_list);
+ALIST_SORT(uint32_t, intro_list, CMP);
+
+ALIST_PROTO(uint32_t, radix_list);
+ALIST(uint32_t, radix_list);
+ALIST_RADIX_SORT_PROTO(uint32_t, radix_list);
+ALIST_RADIX_SORT(uint32_t, radix_list, KEY);
+
+uint32_t rng_state = 2463534242u;
+
+/* xorshift32, rand() only gives 15 bits on some platforms */
+uint32_t rng(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+int qsort_cmp(const void *a, const void *b)
+{
+	return CMP(*(const uint32_t *)a, *(const uint32_t *)b);
+}
+
+double seconds(clock_t start)
+{
+	return (clock() - start) * 1.0 / CLOCKS_PER_SEC;
+}
+
+int is_sorted(const uint32_t *arr, int len)
+{
+	int i;
+	for (i=1; i<len; ++i) {
+		if (arr[i-1] > arr[i]) return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	intro_list *a;
+	radix_list *b;
+	uint32_t *c, *eyt, *queries;
+	uint32_t sum;
+	int len, i, k;
+	clock_t start;
+
+	len = argc > 1 ? atoi(argv[1]) : LEN;
+	a = intro_list_new_cap(len > 1 ? len : 2);
+	b = radix_list_new_cap(len > 1 ? len : 2);
+	c = malloc(len * sizeof(uint32_t));
+	queries = malloc(LOOKUPS * sizeof(uint32_t));
+	if (!a || !b || !c || !queries) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	for (i=0; i<len; ++i) {
+		c[i] = rng();
+		intro_list_insert(a, c[i], -1);
+		radix_list_insert(b, c[i], -1);
+	}
+	/* half of the searches hit */
+	for (i=0; i<LOOKUPS; ++i) {
+		queries[i] = i%2 && len > 0 ? c[rng()%len] : rng();
+	}
+
+	printf("%d random uint32_t elements\n", len);
+
+	start = clock();
+	qsort(c, len, sizeof(uint32_t), qsort_cmp);
+	printf("%-22s %8.3f s\n", "qsort", seconds(start));
+
+	start = clock();
+	intro_list_sort(a);
+	printf("%-22s %8.3f s\n", "intro_list_sort", seconds(start));
+
+	start = clock();
+	radix_list_sort(b);
+	printf("%-22s %8.3f s\n", "radix_list_sort", seconds(start));
+
+	if (!is_sorted(c, len) || !is_sorted(a->arr, len) || !is_sorted(b->arr, len)) {
+		fprintf(stderr, "not sorted\n");
+		return 1;
+	}
+
+	printf("%d searches\n", LOOKUPS);
+
+	/* the sums keep the searches from being optimized out */
+	sum = 0;
+	start = clock();
+	for (i=0; i<LOOKUPS; ++i) {
+		sum += bsearch(&queries[i], c, len, sizeof(uint32_t), qsort_cmp) != NULL;
+	}
+	printf("%-22s %8.3f s (%u)\n", "bsearch", seconds(start), sum);
+
+	sum = 0;
+	start = clock();
+	for (i=0; i<LOOKUPS; ++i) {
+		sum += intro_list_binary_search(a, queries[i]) >= 0;
+	}
+	printf("%-22s %8.3f s (%u)\n", "binary_search", seconds(start), sum);
+
+	eyt = intro_list_eytzinger(a);
+	if (!eyt) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	sum = 0;
+	start = clock();
+	for (i=0; i<LOOKUPS; ++i) {
+		k = intro_list_eytzinger_search(eyt, len, queries[i]);
+		sum += k && eyt[k] == queries[i];
+	}
+	printf("%-22s %8.3f s (%u)\n", "eytzinger_search", seconds(start), sum);
+
+	free(eyt);
+	free(queries);
+	free(c);
+	intro_list_free(a);
+	radix_list_free(b);
+
+	return 0;
+}
@@ -8,6 +8,10 @@ TREE_PROTO( const char *, tree );
 TREE( const char *, tree );
 UNIQUE( tree *, utree );
 
+/* a read-only copy of a tree ordered by strcmp, searched without pointers */
+TREE_FROZEN_PROTO( const char *, tree );
+TREE_FROZEN( const char *, tree, strcmp );
+
 void printtree( const tree *t ){
 	if ( t ){
 		printf( "[%u] %s\n", tree_size( t ), t->item );
@@ -16,6 +20,61 @@ void printtree( const tree *t ){
 	}
 }
 
+/* returns 1 if an in-order walk of f both ways gives the len words */
+int check_frozen( const tree_frozen *f, const char **words, int len ){
+	tree_frozen_iterator i;
+	int n = 0;
+
+	if ( tree_frozen_size( f ) != len ) return 0;
+	for ( i = tree_frozen_iterate( f ); tree_frozen_next( f, &i ); ++n ){
+		if ( n >= len || strcmp( tree_frozen_get_at( f, i ), words[n] )) return 0;
+	}
+	if ( n != len ) return 0;
+	for ( i = tree_frozen_iterate( f ); tree_frozen_prev( f, &i ); ){
+		if ( strcmp( tree_frozen_get_at( f, i ), words[--n] )) return 0;
+	}
+	return n == 0;
+}
+
+int frozen_example( void ){
+	const char *words[] = { "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf" };
+	tree *t;
+	tree_frozen *f;
+	tree_frozen view;
+	tree_frozen_iterator i;
+	void *image;
+	int n, ok;
+
+	t = tree_construct( "delta",
+			tree_construct( "bravo", tree_new( "alpha" ), tree_new( "charlie" )),
+			tree_construct( "foxtrot", tree_new( "echo" ), tree_new( "golf" )));
+	f = tree_freeze( t );
+	tree_free_all( t );
+	if ( !f || !check_frozen( f, words, 7 )) return 0;
+
+	for ( n = 0; n < 7; ++n ){
+		i = tree_frozen_find( f, words[n] );
+		if ( !i || strcmp( tree_frozen_get_at( f, i ), words[n] )) return 0;
+	}
+	if ( tree_frozen_find( f, "hotel" )) return 0;
+	i = tree_frozen_lower_bound( f, "d" );
+	if ( !i || strcmp( tree_frozen_get_at( f, i ), "delta" )) return 0;
+	if ( tree_frozen_lower_bound( f, "zulu" )) return 0;
+
+	/* the image holds the pointers, so it's only valid in this process */
+	image = malloc( tree_frozen_image_size( f ));
+	if ( !image ) return 0;
+	tree_frozen_save( f, image );
+	ok = tree_frozen_view( &view, image, tree_frozen_image_size( f ))
+		&& check_frozen( &view, words, 7 )
+		&& !tree_frozen_view( &view, image, tree_frozen_image_size( f ) - 1 );
+	printf( "frozen: %d items, image of %lu bytes\n", tree_frozen_size( f ),
+			(unsigned long)tree_frozen_image_size( f ));
+	free( image );
+	tree_frozen_free( f );
+	return ok;
+}
+
 int main( int argc, char *argv[] ){
 	unique(utree, meh, tree_free_all) =
 		tree_construct( "testing",
@@ -26,5 +85,9 @@ int main( int argc, char *argv[] ){
 
 	printtree( meh.data );
 
+	/* the items of meh aren't in order, so it can't be frozen */
+	if ( tree_freeze( meh.data )) return 1;
+	if ( !frozen_example()) return 1;
+
 	return 0;
 } 
@@ -0,0 +1,59 @@
+/*
+ * A list of up to 64M ints in reserved address space: it grows past a few
+ * pages without moving, gives the pages back when it shrinks and fails to
+ * grow past its reservation.
+ *
+ * gcc -ansi -D_DEFAULT_SOURCE -I.. vmalist-example.c -o vmalist-example
+ */
+
+#include <stdio.h>
+#include "vmalist.h"
+
+#define RESERVE (64L * 1024 * 1024)
+
+ALIST_PROTO(int, big_list);
+ALIST_VM(int, big_list, RESERVE);
+
+ALIST_PROTO(int, tiny_list);
+ALIST_VM(int, tiny_list, 100);
+
+int main(void)
+{
+	big_list *list;
+	tiny_list *tiny;
+	int *first;
+	int i;
+
+	list = big_list_new();
+	if (!list) return 1;
+	printf("reserved %lu bytes, committed %lu\n", (unsigned long)list->reserved, (unsigned long)list->committed);
+
+	/* growing commits more pages, the elements stay where they are */
+	first = list->arr;
+	for (i = 0; i < 100000; ++i) {
+		if (!big_list_insert(list, i, -1)) return 1;
+	}
+	if (list->arr != first || big_list_get(list, 99999) != 99999) return 1;
+	printf("%d elements, committed %lu bytes\n", big_list_size(list), (unsigned long)list->committed);
+
+	/* shrinking returns the pages past the new capacity to the OS */
+	if (!big_list_resize(list, 1000) || big_list_get(list, -1) != 999) return 1;
+	printf("%d elements, committed %lu bytes\n", big_list_size(list), (unsigned long)list->committed);
+	list->len = 0;
+	if (!big_list_shrink_to_fit(list) || !big_list_insert(list, 7, -1) || big_list_get(list, 0) != 7) return 1;
+	printf("%d element, committed %lu bytes\n", big_list_size(list), (unsigned long)list->committed);
+
+	/* without any pages, inserting commits one again */
+	if (!big_list_resize(list, 0) || list->cap != 0 || !big_list_insert(list, 8, -1) || big_list_get(list, 0) != 8) return 1;
+	big_list_free(list);
+
+	/* a list can't grow past its reservation */
+	tiny = tiny_list_new();
+	if (!tiny) return 1;
+	for (i = 0; tiny_list_insert(tiny, i, -1); ++i);
+	printf("the tiny list is full at %d elements\n", tiny_list_size(tiny));
+	if (i != 100) return 1;
+	tiny_list_free(tiny);
+
+	return 0;
+}
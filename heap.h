@@ -0,0 +1,198 @@
+/* heap.h: a CPP-based template implementation of d-ary heap (priority queue) */
+
+#ifndef HEAP_H_INCLUDED
+#define HEAP_H_INCLUDED 1
+
+#include <stdlib.h>
+#include <string.h>
+#include "container.h"
+
+#define HEAP_PROTO(T, N) \
+	typedef struct N N; \
+	N *N##_new(void); \
+	N *N##_new_cap(container_size size); \
+	void N##_free(N *h); \
+	int N##_init(N *h); \
+	int N##_init_cap(N *h, container_size size); \
+	void N##_destroy(N *h); \
+	container_size N##_size(const N *h); \
+	int N##_push(N *h, T item); \
+	T N##_pop(N *h); \
+	T N##_peek(const N *h); \
+	T N##_remove(N *h, container_size pos); \
+	void N##_decrease_key(N *h, container_size pos, T item); \
+	void N##_heapify(N *h); \
+	int N##_heapify_from_array(N *h, T const *arr, container_size len)
+
+/*
+ * defines a min-heap of T elements named N, stored in an array like alist;
+ * int CMP(T a, T b) compares like in ALIST_SORT and is expanded in the
+ * generated code; every node has ARITY (at least 2) children, 4 halves the
+ * depth of a binary heap and keeps the children in a cache line for small T
+ */
+#define HEAP(T, N, CMP, ARITY) \
+	HEAP_BODY_(T, N, CMP, ARITY, HEAP_UNTRACKED_)
+
+/*
+ * same as HEAP, but calls MOVED(T item, container_size pos) each time an
+ * element is put at position pos of the heap, and with pos -1 when it's
+ * removed, so the elements can keep their positions for N##_decrease_key and
+ * N##_remove (e.g. the entries of a timer queue, to cancel them); MOVED is
+ * expanded in the generated code, so it can be a macro
+ */
+#define HEAP_TRACKED(T, N, CMP, ARITY, MOVED) \
+	HEAP_BODY_(T, N, CMP, ARITY, MOVED)
+
+#define HEAP_UNTRACKED_(item, pos) ((void)0)
+
+#define HEAP_BODY_(T, N, CMP, ARITY, MOVED) \
+	struct N { container_size cap; container_size len; T *arr; }; \
+	N *N##_new(void) \
+	{ \
+		return N##_new_cap(8); \
+	} \
+	N *N##_new_cap(container_size size) \
+	{ \
+		N *h; \
+		h = CONTAINER_MALLOC(sizeof(struct N)); \
+		if (!h) return NULL; \
+		if (!N##_init_cap(h, size)) { CONTAINER_FREE(h); return NULL; } \
+		return h; \
+	} \
+	void N##_free(N *h) \
+	{ \
+		N##_destroy(h); \
+		CONTAINER_FREE(h); \
+	} \
+	int N##_init(N *h) \
+	{ \
+		return N##_init_cap(h, 8); \
+	} \
+	int N##_init_cap(N *h, container_size size) \
+	{ \
+		h->len = 0; \
+		h->cap = size; \
+		if (CONTAINER_OVERFLOWS(size, sizeof(T))) return 0; \
+		h->arr = CONTAINER_MALLOC(size * sizeof(T)); \
+		return h->arr != NULL; \
+	} \
+	void N##_destroy(N *h) \
+	{ \
+		CONTAINER_FREE(h->arr); \
+	} \
+	container_size N##_size(const N *h) \
+	{ \
+		return h->len; \
+	} \
+	int N##_reserve_(N *h, container_size size) \
+	{ \
+		T *temp; \
+		if (size <= h->cap) return 1; \
+		if (CONTAINER_OVERFLOWS(size, sizeof(T))) return 0; \
+		temp = CONTAINER_REALLOC(h->arr, size * sizeof(T)); \
+		if (!temp) return 0; \
+		h->arr = temp; \
+		h->cap = size; \
+		return 1; \
+	} \
+	/* moves the hole at i up to the place of item, moving its parents down */ \
+	void N##_sift_up_(N *h, container_size i, T item) \
+	{ \
+		container_size parent; \
+		while (i > 0) { \
+			parent = (i - 1) / (ARITY); \
+			if (CMP(item, h->arr[parent]) >= 0) break; \
+			h->arr[i] = h->arr[parent]; \
+			MOVED(h->arr[i], i); \
+			i = parent; \
+		} \
+		h->arr[i] = item; \
+		MOVED(h->arr[i], i); \
+	} \
+	/* moves the hole at i down to the place of item, moving its smallest children up */ \
+	void N##_sift_down_(N *h, container_size i, T item) \
+	{ \
+		container_size child, end, best, c; \
+		for (;;) { \
+			if (i > (h->len - 1) / (ARITY)) break; \
+			child = i * (ARITY) + 1; \
+			if (child >= h->len) break; \
+			end = h->len - child > (ARITY) ? child + (ARITY) : h->len; \
+			best = child; \
+			for (c=child+1; c<end; ++c) { \
+				if (CMP(h->arr[c], h->arr[best]) < 0) best = c; \
+			} \
+			if (CMP(h->arr[best], item) >= 0) break; \
+			h->arr[i] = h->arr[best]; \
+			MOVED(h->arr[i], i); \
+			i = best; \
+		} \
+		h->arr[i] = item; \
+		MOVED(h->arr[i], i); \
+	} \
+	int N##_push(N *h, T item) \
+	{ \
+		if (h->len >= h->cap) { \
+			if (h->cap == CONTAINER_SIZE_MAX || !N##_reserve_(h, CONTAINER_GROW(h->cap))) return 0; \
+		} \
+		N##_sift_up_(h, h->len++, item); \
+		return 1; \
+	} \
+	T N##_pop(N *h) \
+	{ \
+		return N##_remove(h, 0); \
+	} \
+	T N##_peek(const N *h) \
+	{ \
+		return h->arr[0]; \
+	} \
+	/* removes the element at pos and returns it */ \
+	T N##_remove(N *h, container_size pos) \
+	{ \
+		T item; \
+		T last; \
+		item = h->arr[pos]; \
+		last = h->arr[--h->len]; \
+		MOVED(item, -1); \
+		if (pos < h->len) { \
+			if (pos > 0 && CMP(last, h->arr[(pos - 1) / (ARITY)]) < 0) { \
+				N##_sift_up_(h, pos, last); \
+			} else { \
+				N##_sift_down_(h, pos, last); \
+			} \
+		} \
+		return item; \
+	} \
+	/* replaces the element at pos with item, which must not be greater than it */ \
+	void N##_decrease_key(N *h, container_size pos, T item) \
+	{ \
+		N##_sift_up_(h, pos, item); \
+	} \
+	/* restores the heap order of arr after changing it directly, O(len) */ \
+	void N##_heapify(N *h) \
+	{ \
+		container_size i; \
+		if (h->len < 2) { \
+			if (h->len) MOVED(h->arr[0], 0); \
+			return; \
+		} \
+		for (i=(h->len - 2) / (ARITY) + 1; i-- > 0; ) { \
+			N##_sift_down_(h, i, h->arr[i]); \
+		} \
+		/* sift_down_ didn't put all leaves, report their positions too */ \
+		for (i=(h->len - 2) / (ARITY) + 1; i<h->len; ++i) { \
+			MOVED(h->arr[i], i); \
+		} \
+	} \
+	/* replaces the elements of the heap with len elements of arr, O(len) */ \
+	int N##_heapify_from_array(N *h, T const *arr, container_size len) \
+	{ \
+		if (!N##_reserve_(h, len)) return 0; \
+		if (len) memcpy(h->arr, arr, len * sizeof(T)); \
+		h->len = len; \
+		N##_heapify(h); \
+		return 1; \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+#endif /* ifndef HEAP_H_INCLUDED */
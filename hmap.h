@@ -3,42 +3,208 @@
 #ifndef HMAP_H_INCLUDED
 #define HMAP_H_INCLUDED 1
 
-#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include "container.h"
+#include "bloom.h" /* for HMAP_FILTERED */
 
 #define HMAP_BUCKET_SIZE 1 /* starting bucket size */
 #define HMAP_MIN_CAP 16 /* minimum number of buckets when autoresizing down */
 #define HMAP_MAX_LOAD 2.0 /* max load before growing to twice the current capacity; negative to disable */
 #define HMAP_MIN_LOAD 0.5 /* min load before shrinking to half; negative to disable; must be less than HMAP_MAX_LOAD/2 */
 
+/*
+ * a string key with its length, e.g. for strings that aren't null-terminated;
+ * use hmap_strview_cmp as the comparison function, it only compares the bytes
+ * of strings of equal length
+ */
+typedef struct hmap_strview { size_t len; const char *str; } hmap_strview;
+#define hmap_strview_cmp(a, b) ((a).len != (b).len ? ((a).len < (b).len ? -1 : 1) : memcmp((a).str, (b).str, (a).len))
+
+#define HMAP_STATS_PROBES 8 /* length of the probe histogram, the last element counts all longer probes */
+
+/*
+ * counters of a map's operations, returned by N##_stats; they are only
+ * collected when HMAP_STATS is defined before including hmap.h (in every file
+ * using the map), otherwise the code counting them isn't compiled at all and
+ * N##_stats returns zeroes
+ */
+typedef struct hmap_stats {
+	unsigned long lookups; /* key lookups of get, set, upsert, delete etc. */
+	unsigned long hits; /* lookups which found the key */
+	unsigned long misses; /* lookups which didn't */
+	unsigned long compares; /* calls of the comparison function */
+	unsigned long probes[HMAP_STATS_PROBES]; /* lookups by the number of entries they checked */
+	unsigned long resizes; /* calls of N##_resize, also by automatic resizing */
+	double resize_ns; /* time spent in N##_resize */
+	unsigned long bucket_reallocs; /* entry arrays of buckets allocated, grown or shrunk by set and delete */
+	unsigned long filtered; /* misses of HMAP_FILTERED maps rejected by the filter without checking a bucket */
+	unsigned long bytes; /* bytes allocated for buckets and entries, kept by N##_stats_reset; must be last */
+} hmap_stats;
+
+/* the helpers collecting the stats, or doing nothing */
+#ifdef HMAP_STATS
+#include <time.h>
+/*
+ * the clock timing resizes in nanoseconds: HMAP_STATS_CLOCK() if it's defined,
+ * else the monotonic clock of clock_gettime where POSIX declares it (with
+ * -ansi, define e.g. _POSIX_C_SOURCE=199309L), else clock(), which counts CPU
+ * time in ticks of 1/CLOCKS_PER_SEC s, too coarse for most single resizes
+ */
+#if !defined(HMAP_STATS_CLOCK) && defined(CLOCK_MONOTONIC)
+#define HMAP_STATS_NOW_(N) N##_stats_clock_()
+#define HMAP_STATS_FUNCTIONS_(N) \
+	double N##_stats_clock_(void) \
+	{ \
+		struct timespec ts; \
+		if (clock_gettime(CLOCK_MONOTONIC, &ts)) return 0.0; \
+		return ts.tv_sec * 1e9 + ts.tv_nsec; \
+	}
+#else
+#ifndef HMAP_STATS_CLOCK
+#define HMAP_STATS_CLOCK() (clock() * (1e9 / CLOCKS_PER_SEC))
+#endif
+#define HMAP_STATS_NOW_(N) HMAP_STATS_CLOCK()
+#define HMAP_STATS_FUNCTIONS_(N)
+#endif
+#define HMAP_STATS_FIELD_ hmap_stats stats_;
+/* lookups take a const map, but its stats change anyway, so concurrent lookups race */
+#define HMAP_STAT_ADD_(map, field, n) (((hmap_stats *)&(map)->stats_)->field += (n))
+#define HMAP_STAT_SUB_(map, field, n) ((map)->stats_.field -= (n))
+#define HMAP_STAT_SET_(map, field, n) ((map)->stats_.field = (n))
+#define HMAP_STATS_INIT_(map) memset(&(map)->stats_, 0, sizeof(hmap_stats))
+#define HMAP_STATS_GET_(map, out) (*(out) = (map)->stats_)
+#define HMAP_STATS_RESET_(map) memset(&(map)->stats_, 0, offsetof(hmap_stats, bytes))
+#else
+#define HMAP_STATS_FIELD_
+#define HMAP_STAT_ADD_(map, field, n) ((void)(n))
+#define HMAP_STAT_SUB_(map, field, n) ((void)(n))
+#define HMAP_STAT_SET_(map, field, n) ((void)(n))
+#define HMAP_STATS_NOW_(N) 0.0
+#define HMAP_STATS_FUNCTIONS_(N)
+#define HMAP_STATS_INIT_(map) ((void)0)
+#define HMAP_STATS_GET_(map, out) memset(out, 0, sizeof(hmap_stats))
+#define HMAP_STATS_RESET_(map) ((void)0)
+#endif
+#define HMAP_STAT_PROBE_(map, n) HMAP_STAT_ADD_(map, probes[(n) < HMAP_STATS_PROBES ? (n) : HMAP_STATS_PROBES-1], 1)
+
 #define HMAP_PROTO(K, V, N) \
 	typedef struct N##_entry N##_entry; \
 	typedef struct N##_bucket N##_bucket; \
 	typedef struct N N; \
 	typedef struct N##_iterator N##_iterator; \
 	N *N##_new(void); \
-	N *N##_new_cap(int cap); \
+	N *N##_new_cap(container_size cap); \
 	void N##_free(N *map); \
-	int N##_size(const N *map); \
-	int N##_resize(N *map, int cap); \
+	int N##_init(N *map); \
+	int N##_init_cap(N *map, container_size cap); \
+	void N##_destroy(N *map); \
+	container_size N##_size(const N *map); \
+	int N##_resize(N *map, container_size cap); \
+	int N##_compact(N *map); \
+	void N##_clear(N *map, int keep_capacity); \
+	void N##_stats(const N *map, hmap_stats *out); \
+	void N##_stats_reset(N *map); \
 	V N##_get(const N *map, K key); \
 	int N##_contains(const N *map, K key); \
-	int N##_get_default(const N *map, K key, V def); \
+	V N##_get_default(const N *map, K key, V def); \
 	int N##_get_contains(const N *map, K key, V *value); \
+	V *N##_get_ref(N *map, K key); \
 	int N##_set(N *map, K key, V value); \
+	V *N##_upsert(N *map, K key, int *inserted); \
 	int N##_delete(N *map, K key); \
+	int N##_take(N *map, K key, V *value); \
+	int N##_get_hashed(const N *map, K key, container_hash hash, V *value); \
+	int N##_set_hashed(N *map, K key, container_hash hash, V value); \
+	int N##_delete_hashed(N *map, K key, container_hash hash); \
 	N##_iterator N##_iterate(const N *map); \
 	int N##_next(const N *map, N##_iterator *iter); \
 	K N##_key_at(const N *map, N##_iterator iter); \
 	V N##_value_at(const N *map, N##_iterator iter)
 
 #define HMAP(K, V, N, C, H) \
-	struct N##_entry { uint32_t hash; K key; V value; }; \
-	struct N##_bucket { int len; int cap; struct N##_entry *entries; }; \
-	struct N { int len; int cap; struct N##_bucket *buckets; double max_load; double min_load; }; \
-	struct N##_iterator { int bucket; int entry; }; \
-	uint32_t N##_hash(K _hmap_key) \
+	HMAP_STRUCT_(K, V, N, HMAP_UNFILTERED); \
+	HMAP_BODY_(K, V, N, C, H, HMAP_UNFILTERED)
+
+/*
+ * HMAP split in two: HMAP_STRUCT defines the structs, so they can go in a
+ * header after HMAP_PROTO for a map embedded by value in another struct, and
+ * HMAP_FUNCTIONS then defines the functions in one .c file
+ */
+#define HMAP_STRUCT(K, V, N) \
+	HMAP_STRUCT_(K, V, N, HMAP_UNFILTERED)
+
+#define HMAP_FUNCTIONS(K, V, N, C, H) \
+	HMAP_BODY_(K, V, N, C, H, HMAP_UNFILTERED)
+
+/* header entries for a filtered hmap: those of HMAP_PROTO, N##_filter_rebuild and the filter N##_filter */
+#define HMAP_FILTERED_PROTO(K, V, N) \
+	HMAP_PROTO(K, V, N); \
+	BLOOM_PROTO(K, N##_filter); \
+	int N##_filter_rebuild(N *map)
+
+/*
+ * same as HMAP, but the map keeps a bloom filter of its keys, which lookups
+ * check before the buckets, so most misses only touch one cache line of the
+ * filter; the filter is rebuilt for the new capacity on every resize, which
+ * also drops the bits of deleted keys
+ */
+#define HMAP_FILTERED(K, V, N, C, H) \
+	BLOOM(K, N##_filter, H); \
+	HMAP_STRUCT_(K, V, N, HMAP_FILTER); \
+	HMAP_BODY_(K, V, N, C, H, HMAP_FILTER)
+
+/* the number of keys the filter of a map is sized for, the most it holds before growing */
+#define HMAP_FILTER_KEYS_(map) ((container_size)((map)->cap * ((map)->max_load > 0 ? (map)->max_load : HMAP_MAX_LOAD)))
+
+/* the hooks of HMAP_BODY_ keeping the filter, F##_... with F HMAP_FILTER or HMAP_UNFILTERED */
+#define HMAP_FILTER_FIELD_(N) N##_filter filter_;
+#define HMAP_FILTER_INIT_(N, map) N##_filter_init(&(map)->filter_, HMAP_FILTER_KEYS_(map))
+#define HMAP_FILTER_DESTROY_(N, map) N##_filter_destroy(&(map)->filter_)
+#define HMAP_FILTER_REBUILD_(N, map) ((void)N##_filter_rebuild(map))
+#define HMAP_FILTER_CLEAR_(N, map) N##_filter_clear(&(map)->filter_)
+#define HMAP_FILTER_ADD_(N, map, hash) N##_filter_add_hashed(&(map)->filter_, hash)
+#define HMAP_FILTER_MAY_CONTAIN_(N, map, hash) N##_filter_contains_hashed(&(map)->filter_, hash)
+/* replaces the filter with one sized for the capacity of the map; on malloc failure, keeps the old one */
+#define HMAP_FILTER_FUNCTIONS_(N) \
+	int N##_filter_rebuild(N *map) \
+	{ \
+		N##_filter filter; \
+		container_size i, j; \
+		if (!N##_filter_init(&filter, HMAP_FILTER_KEYS_(map))) return 0; \
+		for (i=0; i<map->cap; ++i) { \
+			for (j=0; j<map->buckets[i].len; ++j) { \
+				N##_filter_add_hashed(&filter, map->buckets[i].entries[j].hash); \
+			} \
+		} \
+		N##_filter_destroy(&map->filter_); \
+		map->filter_ = filter; \
+		return 1; \
+	}
+#define HMAP_UNFILTERED_FIELD_(N)
+#define HMAP_UNFILTERED_INIT_(N, map) 1
+#define HMAP_UNFILTERED_DESTROY_(N, map) ((void)0)
+#define HMAP_UNFILTERED_REBUILD_(N, map) ((void)0)
+#define HMAP_UNFILTERED_CLEAR_(N, map) ((void)0)
+#define HMAP_UNFILTERED_ADD_(N, map, hash) ((void)0)
+#define HMAP_UNFILTERED_MAY_CONTAIN_(N, map, hash) 1
+#define HMAP_UNFILTERED_FUNCTIONS_(N)
+
+/*
+ * the structs and the functions of HMAP and HMAP_FILTERED; F is the prefix of
+ * the filter hooks, which expand to nothing (or 1 for the checks) with
+ * HMAP_UNFILTERED
+ */
+#define HMAP_STRUCT_(K, V, N, F) \
+	struct N##_entry { container_hash hash; K key; V value; }; \
+	struct N##_bucket { container_size len; container_size cap; struct N##_entry *entries; }; \
+	struct N { container_size len; container_size cap; struct N##_bucket *buckets; struct N##_entry *slab; double max_load; double min_load; F##_FIELD_(N) HMAP_STATS_FIELD_ }; \
+	struct N##_iterator { container_size bucket; container_size entry; }
+
+#define HMAP_BODY_(K, V, N, C, H, F) \
+	F##_FUNCTIONS_(N) \
+	HMAP_STATS_FUNCTIONS_(N) \
+	container_hash N##_hash(K _hmap_key) \
 	{ \
 		return H(_hmap_key); \
 	} \
@@ -50,167 +216,397 @@
 	{ \
 		return N##_new_cap(HMAP_MIN_CAP); \
 	} \
-	N *N##_new_cap(int cap) \
+	N *N##_new_cap(container_size cap) \
 	{ \
 		N *map; \
-		map = malloc(sizeof(struct N)); \
+		map = CONTAINER_MALLOC(sizeof(struct N)); \
 		if (!map) return NULL; \
+		if (!N##_init_cap(map, cap)) { \
+			CONTAINER_FREE(map); \
+			return NULL; \
+		} \
+		return map; \
+	} \
+	void N##_free(N *map) \
+	{ \
+		N##_destroy(map); \
+		CONTAINER_FREE(map); \
+	} \
+	int N##_init(N *map) \
+	{ \
+		return N##_init_cap(map, HMAP_MIN_CAP); \
+	} \
+	int N##_init_cap(N *map, container_size cap) \
+	{ \
 		map->len = 0; \
 		map->cap = cap; \
+		map->slab = NULL; \
 		map->max_load = HMAP_MAX_LOAD; \
 		map->min_load = HMAP_MIN_LOAD; \
-		map->buckets = malloc(cap * sizeof(struct N##_bucket)); \
-		if (!map->buckets) { \
-			free(map); \
-			return NULL; \
-		} \
+		HMAP_STATS_INIT_(map); \
+		if (CONTAINER_OVERFLOWS(cap, sizeof(struct N##_bucket))) return 0; \
+		map->buckets = CONTAINER_MALLOC(cap * sizeof(struct N##_bucket)); \
+		if (!map->buckets) return 0; \
 		memset(map->buckets, 0, cap*sizeof(struct N##_bucket)); \
-		return map; \
+		if (!F##_INIT_(N, map)) { \
+			CONTAINER_FREE(map->buckets); \
+			return 0; \
+		} \
+		HMAP_STAT_ADD_(map, bytes, cap*sizeof(struct N##_bucket)); \
+		return 1; \
 	} \
-	void N##_free(N *map) \
+	void N##_destroy(N *map) \
 	{ \
-		int i; \
+		container_size i; \
 		for (i=0; i<map->cap; ++i) { \
-			if (map->buckets[i].cap > 0) free(map->buckets[i].entries); \
+			if (map->buckets[i].cap > 0) CONTAINER_FREE(map->buckets[i].entries); \
 		} \
-		free(map->buckets); \
-		free(map); \
+		CONTAINER_FREE(map->buckets); \
+		CONTAINER_FREE(map->slab); \
+		F##_DESTROY_(N, map); \
 	} \
-	int N##_size(const N *map) \
+	container_size N##_size(const N *map) \
 	{ \
 		return map->len; \
 	} \
-	int N##_resize(N *map, int cap) \
+	int N##_resize(N *map, container_size cap) \
 	{ \
 		N##_bucket *buckets, *oldb, *newb; \
 		N##_entry *entries; \
-		int i, j, k, newcap; \
-		buckets = malloc(cap * sizeof(struct N##_bucket)); \
+		container_size i, j, k, newcap; \
+		size_t bytes; \
+		double start; \
+		start = HMAP_STATS_NOW_(N); \
+		HMAP_STAT_ADD_(map, resizes, 1); \
+		if (CONTAINER_OVERFLOWS(cap, sizeof(struct N##_bucket))) return 0; \
+		buckets = CONTAINER_MALLOC(cap * sizeof(struct N##_bucket)); \
 		if (!buckets) return 0; \
 		memset(buckets, 0, cap*sizeof(struct N##_bucket)); \
+		bytes = cap * sizeof(struct N##_bucket); \
 		for (i=0; i<map->cap; ++i) { \
 			oldb = &map->buckets[i]; \
 			for (j=0; j<oldb->len; ++j) { \
 				newb = &buckets[oldb->entries[j].hash%cap]; \
 				if (newb->cap == newb->len) { \
 					newcap = newb->cap>0 ? 2*newb->cap : HMAP_BUCKET_SIZE; \
-					entries = realloc(newb->entries, newcap*sizeof(struct N##_entry)); \
+					entries = CONTAINER_REALLOC(newb->entries, newcap*sizeof(struct N##_entry)); \
 					if (!entries) { \
-						for (k=0; cap; ++k) if (buckets[k].cap > 0) free(buckets[k].entries); \
-						free(buckets); \
+						for (k=0; k<cap; ++k) if (buckets[k].cap > 0) CONTAINER_FREE(buckets[k].entries); \
+						CONTAINER_FREE(buckets); \
 						return 0; \
 					} \
 					newb->entries = entries; \
+					bytes += (newcap - newb->cap) * sizeof(struct N##_entry); \
 					newb->cap = newcap; \
 				} \
 				newb->entries[newb->len++] = oldb->entries[j]; \
 			} \
 		} \
 		for (i=0; i<map->cap; ++i) { \
-			if (map->buckets[i].cap > 0) free(map->buckets[i].entries); \
+			if (map->buckets[i].cap > 0) CONTAINER_FREE(map->buckets[i].entries); \
 		} \
-		free(map->buckets); \
+		CONTAINER_FREE(map->buckets); \
+		CONTAINER_FREE(map->slab); \
 		map->cap = cap; \
 		map->buckets = buckets; \
+		map->slab = NULL; \
+		F##_REBUILD_(N, map); \
+		HMAP_STAT_SET_(map, bytes, bytes); \
+		HMAP_STAT_ADD_(map, resize_ns, HMAP_STATS_NOW_(N) - start); \
 		return 1; \
 	} \
-	V N##_get(const N *map, K key) \
+	/* \
+	 * resizes the map to the smallest capacity HMAP_MIN_CAP*2^k with a load of at \
+	 * most 1 (or max_load if it's lower) and moves all entries to one array, the \
+	 * slab, in bucket order; the buckets point into it with cap 0 and copy their \
+	 * entries to an array of their own when an insert needs more room \
+	 */ \
+	int N##_compact(N *map) \
 	{ \
-		V value; \
-		if (!N##_get_contains(map, key, &value)) { \
-			memset(&value, 0, N##_sizeof_value); \
+		N##_bucket *buckets, *oldb, *newb; \
+		N##_entry *slab; \
+		container_size i, j, cap, offset; \
+		double load, start; \
+		start = HMAP_STATS_NOW_(N); \
+		load = map->max_load > 0 && map->max_load < 1 ? map->max_load : 1; \
+		for (cap=HMAP_MIN_CAP; map->len > cap*load && cap <= CONTAINER_SIZE_MAX/2; cap*=2); \
+		if (CONTAINER_OVERFLOWS(cap, sizeof(struct N##_bucket)) || CONTAINER_OVERFLOWS(map->len, sizeof(struct N##_entry))) return 0; \
+		buckets = CONTAINER_MALLOC(cap * sizeof(struct N##_bucket)); \
+		if (!buckets) return 0; \
+		memset(buckets, 0, cap*sizeof(struct N##_bucket)); \
+		slab = NULL; \
+		if (map->len > 0) { \
+			slab = CONTAINER_MALLOC(map->len * sizeof(struct N##_entry)); \
+			if (!slab) { \
+				CONTAINER_FREE(buckets); \
+				return 0; \
+			} \
 		} \
-		return value; \
+		HMAP_STAT_ADD_(map, resizes, 1); \
+		/* count the entries of each new bucket, then give it its part of the slab */ \
+		for (i=0; i<map->cap; ++i) { \
+			oldb = &map->buckets[i]; \
+			for (j=0; j<oldb->len; ++j) ++buckets[oldb->entries[j].hash%cap].len; \
+		} \
+		offset = 0; \
+		for (i=0; i<cap; ++i) { \
+			if (buckets[i].len > 0) buckets[i].entries = slab + offset; \
+			offset += buckets[i].len; \
+			buckets[i].len = 0; \
+		} \
+		for (i=0; i<map->cap; ++i) { \
+			oldb = &map->buckets[i]; \
+			for (j=0; j<oldb->len; ++j) { \
+				newb = &buckets[oldb->entries[j].hash%cap]; \
+				newb->entries[newb->len++] = oldb->entries[j]; \
+			} \
+			if (oldb->cap > 0) CONTAINER_FREE(oldb->entries); \
+		} \
+		CONTAINER_FREE(map->buckets); \
+		CONTAINER_FREE(map->slab); \
+		map->cap = cap; \
+		map->buckets = buckets; \
+		map->slab = slab; \
+		F##_REBUILD_(N, map); \
+		HMAP_STAT_SET_(map, bytes, cap*sizeof(struct N##_bucket) + map->len*sizeof(struct N##_entry)); \
+		HMAP_STAT_ADD_(map, resize_ns, HMAP_STATS_NOW_(N) - start); \
+		return 1; \
 	} \
-	int N##_contains(const N *map, K key) \
+	/* \
+	 * removes all entries; with keep_capacity the buckets keep their entry arrays \
+	 * for the next inserts (the slab of N##_compact is freed, its buckets have no \
+	 * spare room), otherwise they are freed and the map shrinks to HMAP_MIN_CAP \
+	 */ \
+	void N##_clear(N *map, int keep_capacity) \
 	{ \
-		return N##_get_contains(map, key, NULL); \
+		N##_bucket *buckets; \
+		container_size i; \
+		size_t bytes; \
+		bytes = map->cap * sizeof(struct N##_bucket); \
+		for (i=0; i<map->cap; ++i) { \
+			if (keep_capacity && map->buckets[i].cap > 0) { \
+				bytes += map->buckets[i].cap * sizeof(struct N##_entry); \
+			} else { \
+				if (map->buckets[i].cap > 0) CONTAINER_FREE(map->buckets[i].entries); \
+				map->buckets[i].entries = NULL; \
+				map->buckets[i].cap = 0; \
+			} \
+			map->buckets[i].len = 0; \
+		} \
+		CONTAINER_FREE(map->slab); \
+		map->slab = NULL; \
+		map->len = 0; \
+		if (keep_capacity || map->cap <= HMAP_MIN_CAP) { \
+			F##_CLEAR_(N, map); \
+		} else { \
+			/* shrinking can't fail, keep the old array if realloc does */ \
+			buckets = CONTAINER_REALLOC(map->buckets, HMAP_MIN_CAP * sizeof(struct N##_bucket)); \
+			if (buckets) map->buckets = buckets; \
+			map->cap = HMAP_MIN_CAP; \
+			bytes = HMAP_MIN_CAP * sizeof(struct N##_bucket); \
+			F##_CLEAR_(N, map); \
+			F##_REBUILD_(N, map); \
+		} \
+		HMAP_STAT_SET_(map, bytes, bytes); \
 	} \
-	int N##_get_default(const N *map, K key, V def) \
+	void N##_stats(const N *map, hmap_stats *out) \
 	{ \
-		N##_get_contains(map, key, &def); \
-		return def; \
+		HMAP_STATS_GET_(map, out); \
 	} \
-	int N##_get_contains(const N *map, K key, V *value) \
+	void N##_stats_reset(N *map) \
+	{ \
+		HMAP_STATS_RESET_(map); \
+	} \
+	/* returns the entry with key or NULL */ \
+	N##_entry *N##_find_(const N *map, K key, container_hash hash) \
 	{ \
 		N##_bucket *bucket; \
-		int i; \
-		uint32_t hash;\
-		hash = N##_hash(key); \
+		container_size i; \
+		HMAP_STAT_ADD_(map, lookups, 1); \
+		if (!F##_MAY_CONTAIN_(N, map, hash)) { \
+			HMAP_STAT_ADD_(map, misses, 1); \
+			HMAP_STAT_ADD_(map, filtered, 1); \
+			HMAP_STAT_PROBE_(map, 0); \
+			return NULL; \
+		} \
 		bucket = &map->buckets[hash%map->cap]; \
 		for (i=0; i<bucket->len; ++i) { \
-			if (bucket->entries[i].hash==hash && !N##_compare(bucket->entries[i].key, key)) { \
-				if (value) { \
-					*value = bucket->entries[i].value; \
-				} \
-				return 1; \
+			if (bucket->entries[i].hash==hash && (HMAP_STAT_ADD_(map, compares, 1), !N##_compare(bucket->entries[i].key, key))) { \
+				HMAP_STAT_ADD_(map, hits, 1); \
+				HMAP_STAT_PROBE_(map, i+1); \
+				return &bucket->entries[i]; \
 			} \
 		} \
-		return 0; \
+		HMAP_STAT_ADD_(map, misses, 1); \
+		HMAP_STAT_PROBE_(map, i); \
+		return NULL; \
 	} \
-	int N##_set(N *map, K key, V value) \
+	/* adds an entry for key, which isn't in the map, with value (zeroed if NULL); returns the new entry or NULL */ \
+	N##_entry *N##_add_(N *map, K key, container_hash hash, V const *value) \
 	{ \
 		N##_bucket *bucket; \
 		N##_entry *tmp; \
-		int i; \
-		uint32_t hash; \
-		hash = N##_hash(key); \
+		container_size cap; \
 		bucket = &map->buckets[hash%map->cap]; \
-		for (i=0; i<bucket->len; ++i) { \
-			if (bucket->entries[i].hash==hash && !N##_compare(bucket->entries[i].key, key)) { \
-				bucket->entries[i].value = value; \
-				return 1; \
-			} \
-		} \
-		if (bucket->len == bucket->cap) { \
+		if (bucket->len >= bucket->cap) { \
 			if (!bucket->cap) { \
-				bucket->entries = malloc(HMAP_BUCKET_SIZE * sizeof(struct N##_entry)); \
-				if (!bucket->entries) return 0; \
-				bucket->cap = HMAP_BUCKET_SIZE; \
+				/* a bucket with entries in the slab of N##_compact moves them to its own array */ \
+				cap = bucket->len > 0 ? 2*bucket->len : HMAP_BUCKET_SIZE; \
+				if (CONTAINER_OVERFLOWS(cap, sizeof(struct N##_entry))) return NULL; \
+				tmp = CONTAINER_MALLOC(cap * sizeof(struct N##_entry)); \
+				if (!tmp) return NULL; \
+				if (bucket->len > 0) memcpy(tmp, bucket->entries, bucket->len * sizeof(struct N##_entry)); \
+				bucket->entries = tmp; \
+				bucket->cap = cap; \
+				HMAP_STAT_ADD_(map, bytes, cap * sizeof(struct N##_entry)); \
 			} else { \
-				tmp = realloc(bucket->entries, 2*bucket->cap*sizeof(struct N##_entry)); \
-				if (!tmp) return 0; \
+				if (CONTAINER_OVERFLOWS(2*bucket->cap, sizeof(struct N##_entry))) return NULL; \
+				tmp = CONTAINER_REALLOC(bucket->entries, 2*bucket->cap*sizeof(struct N##_entry)); \
+				if (!tmp) return NULL; \
 				bucket->entries = tmp; \
+				HMAP_STAT_ADD_(map, bytes, bucket->cap * sizeof(struct N##_entry)); \
 				bucket->cap *= 2; \
 			} \
+			HMAP_STAT_ADD_(map, bucket_reallocs, 1); \
 		} \
-		bucket->entries[bucket->len].key = key; \
-		bucket->entries[bucket->len].value = value; \
-		bucket->entries[bucket->len].hash = hash; \
+		tmp = &bucket->entries[bucket->len]; \
+		tmp->key = key; \
+		if (value) { \
+			tmp->value = *value; \
+		} else { \
+			memset(&tmp->value, 0, N##_sizeof_value); \
+		} \
+		tmp->hash = hash; \
+		F##_ADD_(N, map, hash); \
 		++bucket->len; \
 		++map->len; \
-		if (map->max_load >= 0 && map->len*1.0/map->cap > map->max_load) { \
-			N##_resize(map, 2*map->cap); \
+		if (map->max_load >= 0 && map->len*1.0/map->cap > map->max_load && map->cap <= CONTAINER_SIZE_MAX/2 && N##_resize(map, 2*map->cap)) { \
+			/* the entry has moved, find it without counting another lookup */ \
+			bucket = &map->buckets[hash%map->cap]; \
+			for (tmp=bucket->entries; tmp->hash != hash || N##_compare(tmp->key, key); ++tmp); \
 		} \
-		return 1; \
+		return tmp; \
 	} \
-	int N##_delete(N *map, K key) \
+	/* removes the entry with key and copies its value to *value if it's not NULL */ \
+	int N##_remove_(N *map, K key, container_hash hash, V *value) \
 	{ \
 		N##_bucket *bucket; \
-		int i; \
-		uint32_t hash; \
+		container_size i; \
 		N##_entry *tmp; \
-		hash = N##_hash(key); \
+		HMAP_STAT_ADD_(map, lookups, 1); \
+		if (!F##_MAY_CONTAIN_(N, map, hash)) { \
+			HMAP_STAT_ADD_(map, misses, 1); \
+			HMAP_STAT_ADD_(map, filtered, 1); \
+			HMAP_STAT_PROBE_(map, 0); \
+			return 0; \
+		} \
 		bucket = &map->buckets[hash%map->cap]; \
 		for (i=0; i<bucket->len; ++i) { \
-			if (bucket->entries[i].hash==hash && !N##_compare(bucket->entries[i].key, key)) { \
+			if (bucket->entries[i].hash==hash && (HMAP_STAT_ADD_(map, compares, 1), !N##_compare(bucket->entries[i].key, key))) { \
+				HMAP_STAT_ADD_(map, hits, 1); \
+				HMAP_STAT_PROBE_(map, i+1); \
+				if (value) { \
+					*value = bucket->entries[i].value; \
+				} \
 				for (; i+1<bucket->len; ++i) bucket->entries[i] = bucket->entries[i+1]; \
 				--bucket->len; \
 				--map->len; \
 				if (map->min_load >= 0 && map->len*1.0/map->cap < map->min_load && map->cap > HMAP_MIN_CAP) { \
 					N##_resize(map, map->cap/2>HMAP_MIN_CAP ? map->cap/2 : HMAP_MIN_CAP); \
 				} else if (bucket->len < bucket->cap/2) { \
-					tmp = realloc(bucket->entries, bucket->cap/2*sizeof(struct N##_entry)); \
+					tmp = CONTAINER_REALLOC(bucket->entries, bucket->cap/2*sizeof(struct N##_entry)); \
 					if (tmp) { \
 						bucket->entries = tmp; \
+						HMAP_STAT_SUB_(map, bytes, (bucket->cap - bucket->cap/2) * sizeof(struct N##_entry)); \
+						HMAP_STAT_ADD_(map, bucket_reallocs, 1); \
 						bucket->cap /= 2; \
 					} \
 				} \
 				return 1; \
 			} \
 		} \
+		HMAP_STAT_ADD_(map, misses, 1); \
+		HMAP_STAT_PROBE_(map, i); \
 		return 0; \
 	} \
+	V N##_get(const N *map, K key) \
+	{ \
+		V value; \
+		if (!N##_get_contains(map, key, &value)) { \
+			memset(&value, 0, N##_sizeof_value); \
+		} \
+		return value; \
+	} \
+	int N##_contains(const N *map, K key) \
+	{ \
+		return N##_find_(map, key, N##_hash(key)) != NULL; \
+	} \
+	V N##_get_default(const N *map, K key, V def) \
+	{ \
+		N##_get_contains(map, key, &def); \
+		return def; \
+	} \
+	int N##_get_contains(const N *map, K key, V *value) \
+	{ \
+		return N##_get_hashed(map, key, N##_hash(key), value); \
+	} \
+	V *N##_get_ref(N *map, K key) \
+	{ \
+		N##_entry *entry; \
+		entry = N##_find_(map, key, N##_hash(key)); \
+		return entry ? &entry->value : NULL; \
+	} \
+	int N##_set(N *map, K key, V value) \
+	{ \
+		return N##_set_hashed(map, key, N##_hash(key), value); \
+	} \
+	V *N##_upsert(N *map, K key, int *inserted) \
+	{ \
+		N##_entry *entry; \
+		container_hash hash; \
+		hash = N##_hash(key); \
+		entry = N##_find_(map, key, hash); \
+		if (entry) { \
+			if (inserted) *inserted = 0; \
+			return &entry->value; \
+		} \
+		entry = N##_add_(map, key, hash, NULL); \
+		if (!entry) return NULL; \
+		if (inserted) *inserted = 1; \
+		return &entry->value; \
+	} \
+	int N##_delete(N *map, K key) \
+	{ \
+		return N##_remove_(map, key, N##_hash(key), NULL); \
+	} \
+	int N##_take(N *map, K key, V *value) \
+	{ \
+		return N##_remove_(map, key, N##_hash(key), value); \
+	} \
+	int N##_get_hashed(const N *map, K key, container_hash hash, V *value) \
+	{ \
+		N##_entry *entry; \
+		entry = N##_find_(map, key, hash); \
+		if (!entry) return 0; \
+		if (value) { \
+			*value = entry->value; \
+		} \
+		return 1; \
+	} \
+	int N##_set_hashed(N *map, K key, container_hash hash, V value) \
+	{ \
+		N##_entry *entry; \
+		entry = N##_find_(map, key, hash); \
+		if (entry) { \
+			entry->value = value; \
+			return 1; \
+		} \
+		return N##_add_(map, key, hash, &value) != NULL; \
+	} \
+	int N##_delete_hashed(N *map, K key, container_hash hash) \
+	{ \
+		return N##_remove_(map, key, hash, NULL); \
+	} \
 	N##_iterator N##_iterate(const N *map) \
 	{ \
 		N##_iterator iter; \
@@ -220,7 +616,7 @@
 	} \
 	int N##_next(const N *map, N##_iterator *iter) \
 	{ \
-		int i; \
+		container_size i; \
 		if (iter->entry+1 < map->buckets[iter->bucket].len) { \
 			++iter->entry; \
 			return 1; \
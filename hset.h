@@ -0,0 +1,348 @@
+/* hset.h: a CPP-based template implementation of a hash set */
+
+#ifndef HSET_H_INCLUDED
+#define HSET_H_INCLUDED 1
+
+#include "hmap.h" /* for HMAP_BUCKET_SIZE, HMAP_MIN_CAP, HMAP_MAX_LOAD and HMAP_MIN_LOAD */
+
+#define HSET_PROTO(K, N) \
+	typedef struct N##_entry N##_entry; \
+	typedef struct N##_bucket N##_bucket; \
+	typedef struct N N; \
+	typedef struct N##_iterator N##_iterator; \
+	N *N##_new(void); \
+	N *N##_new_cap(container_size cap); \
+	void N##_free(N *s); \
+	int N##_init(N *s); \
+	int N##_init_cap(N *s, container_size cap); \
+	void N##_destroy(N *s); \
+	container_size N##_size(const N *s); \
+	int N##_resize(N *s, container_size cap); \
+	int N##_contains(const N *s, K key); \
+	int N##_add(N *s, K key); \
+	int N##_remove(N *s, K key); \
+	int N##_union_into(N *out, const N *a, const N *b); \
+	int N##_intersect_into(N *out, const N *a, const N *b); \
+	int N##_difference_into(N *out, const N *a, const N *b); \
+	N##_iterator N##_iterate(const N *s); \
+	int N##_next(const N *s, N##_iterator *iter); \
+	K N##_key_at(const N *s, N##_iterator iter)
+
+/* defines functions for a set of K named N; C and H are the same as in HMAP */
+#define HSET(K, N, C, H) \
+	struct N##_entry { container_hash hash; K key; }; \
+	struct N##_bucket { container_size len; container_size cap; struct N##_entry *entries; }; \
+	struct N { container_size len; container_size cap; struct N##_bucket *buckets; double max_load; double min_load; double saved_min_load_; }; \
+	struct N##_iterator { container_size bucket; container_size entry; }; \
+	container_hash N##_hash(K _hset_key) \
+	{ \
+		return H(_hset_key); \
+	} \
+	int N##_compare(K _hset_a, K _hset_b) { \
+		return C(_hset_a, _hset_b); \
+	} \
+	N *N##_new(void) \
+	{ \
+		return N##_new_cap(HMAP_MIN_CAP); \
+	} \
+	N *N##_new_cap(container_size cap) \
+	{ \
+		N *s; \
+		s = CONTAINER_MALLOC(sizeof(struct N)); \
+		if (!s) return NULL; \
+		if (!N##_init_cap(s, cap)) { \
+			CONTAINER_FREE(s); \
+			return NULL; \
+		} \
+		return s; \
+	} \
+	void N##_free(N *s) \
+	{ \
+		N##_destroy(s); \
+		CONTAINER_FREE(s); \
+	} \
+	int N##_init(N *s) \
+	{ \
+		return N##_init_cap(s, HMAP_MIN_CAP); \
+	} \
+	int N##_init_cap(N *s, container_size cap) \
+	{ \
+		s->len = 0; \
+		s->cap = cap; \
+		s->max_load = HMAP_MAX_LOAD; \
+		s->min_load = HMAP_MIN_LOAD; \
+		if (CONTAINER_OVERFLOWS(cap, sizeof(struct N##_bucket))) return 0; \
+		s->buckets = CONTAINER_MALLOC(cap * sizeof(struct N##_bucket)); \
+		if (!s->buckets) return 0; \
+		memset(s->buckets, 0, cap*sizeof(struct N##_bucket)); \
+		return 1; \
+	} \
+	void N##_destroy(N *s) \
+	{ \
+		container_size i; \
+		for (i=0; i<s->cap; ++i) { \
+			if (s->buckets[i].cap > 0) CONTAINER_FREE(s->buckets[i].entries); \
+		} \
+		CONTAINER_FREE(s->buckets); \
+	} \
+	container_size N##_size(const N *s) \
+	{ \
+		return s->len; \
+	} \
+	int N##_resize(N *s, container_size cap) \
+	{ \
+		N##_bucket *buckets, *oldb, *newb; \
+		N##_entry *entries; \
+		container_size i, j, k, newcap; \
+		if (CONTAINER_OVERFLOWS(cap, sizeof(struct N##_bucket))) return 0; \
+		buckets = CONTAINER_MALLOC(cap * sizeof(struct N##_bucket)); \
+		if (!buckets) return 0; \
+		memset(buckets, 0, cap*sizeof(struct N##_bucket)); \
+		for (i=0; i<s->cap; ++i) { \
+			oldb = &s->buckets[i]; \
+			for (j=0; j<oldb->len; ++j) { \
+				newb = &buckets[oldb->entries[j].hash%cap]; \
+				if (newb->cap == newb->len) { \
+					newcap = newb->cap>0 ? 2*newb->cap : HMAP_BUCKET_SIZE; \
+					entries = CONTAINER_REALLOC(newb->entries, newcap*sizeof(struct N##_entry)); \
+					if (!entries) { \
+						for (k=0; k<cap; ++k) if (buckets[k].cap > 0) CONTAINER_FREE(buckets[k].entries); \
+						CONTAINER_FREE(buckets); \
+						return 0; \
+					} \
+					newb->entries = entries; \
+					newb->cap = newcap; \
+				} \
+				newb->entries[newb->len++] = oldb->entries[j]; \
+			} \
+		} \
+		for (i=0; i<s->cap; ++i) { \
+			if (s->buckets[i].cap > 0) CONTAINER_FREE(s->buckets[i].entries); \
+		} \
+		CONTAINER_FREE(s->buckets); \
+		s->cap = cap; \
+		s->buckets = buckets; \
+		return 1; \
+	} \
+	/* the set operations reuse the hashes stored in the entries of the other sets */ \
+	int N##_contains_hashed_(const N *s, K key, container_hash hash) \
+	{ \
+		N##_bucket *bucket; \
+		container_size i; \
+		bucket = &s->buckets[hash%s->cap]; \
+		for (i=0; i<bucket->len; ++i) { \
+			if (bucket->entries[i].hash==hash && !N##_compare(bucket->entries[i].key, key)) { \
+				return 1; \
+			} \
+		} \
+		return 0; \
+	} \
+	int N##_add_hashed_(N *s, K key, container_hash hash) \
+	{ \
+		N##_bucket *bucket; \
+		N##_entry *tmp; \
+		if (N##_contains_hashed_(s, key, hash)) return 1; \
+		bucket = &s->buckets[hash%s->cap]; \
+		if (bucket->len == bucket->cap) { \
+			if (!bucket->cap) { \
+				bucket->entries = CONTAINER_MALLOC(HMAP_BUCKET_SIZE * sizeof(struct N##_entry)); \
+				if (!bucket->entries) return 0; \
+				bucket->cap = HMAP_BUCKET_SIZE; \
+			} else { \
+				if (CONTAINER_OVERFLOWS(2*bucket->cap, sizeof(struct N##_entry))) return 0; \
+				tmp = CONTAINER_REALLOC(bucket->entries, 2*bucket->cap*sizeof(struct N##_entry)); \
+				if (!tmp) return 0; \
+				bucket->entries = tmp; \
+				bucket->cap *= 2; \
+			} \
+		} \
+		bucket->entries[bucket->len].key = key; \
+		bucket->entries[bucket->len].hash = hash; \
+		++bucket->len; \
+		++s->len; \
+		if (s->max_load >= 0 && s->len*1.0/s->cap > s->max_load && s->cap <= CONTAINER_SIZE_MAX/2) { \
+			N##_resize(s, 2*s->cap); \
+		} \
+		return 1; \
+	} \
+	int N##_remove_hashed_(N *s, K key, container_hash hash) \
+	{ \
+		N##_bucket *bucket; \
+		container_size i; \
+		N##_entry *tmp; \
+		bucket = &s->buckets[hash%s->cap]; \
+		for (i=0; i<bucket->len; ++i) { \
+			if (bucket->entries[i].hash==hash && !N##_compare(bucket->entries[i].key, key)) { \
+				for (; i+1<bucket->len; ++i) bucket->entries[i] = bucket->entries[i+1]; \
+				--bucket->len; \
+				--s->len; \
+				if (s->min_load >= 0 && s->len*1.0/s->cap < s->min_load && s->cap > HMAP_MIN_CAP) { \
+					N##_resize(s, s->cap/2>HMAP_MIN_CAP ? s->cap/2 : HMAP_MIN_CAP); \
+				} else if (bucket->len < bucket->cap/2) { \
+					tmp = CONTAINER_REALLOC(bucket->entries, bucket->cap/2*sizeof(struct N##_entry)); \
+					if (tmp) { \
+						bucket->entries = tmp; \
+						bucket->cap /= 2; \
+					} \
+				} \
+				return 1; \
+			} \
+		} \
+		return 0; \
+	} \
+	int N##_contains(const N *s, K key) \
+	{ \
+		return N##_contains_hashed_(s, key, N##_hash(key)); \
+	} \
+	int N##_add(N *s, K key) \
+	{ \
+		return N##_add_hashed_(s, key, N##_hash(key)); \
+	} \
+	int N##_remove(N *s, K key) \
+	{ \
+		return N##_remove_hashed_(s, key, N##_hash(key)); \
+	} \
+	/* keeps the buckets in place while removing elements during iteration */ \
+	void N##_begin_removal_(N *s) \
+	{ \
+		s->saved_min_load_ = s->min_load; \
+		s->min_load = -1; \
+	} \
+	void N##_end_removal_(N *s) \
+	{ \
+		container_size cap; \
+		s->min_load = s->saved_min_load_; \
+		if (s->min_load < 0) return; \
+		for (cap=s->cap; cap/2 >= HMAP_MIN_CAP && s->len*1.0/cap < s->min_load; cap/=2); \
+		if (cap != s->cap) N##_resize(s, cap); \
+	} \
+	/* adds all elements of src to s */ \
+	int N##_add_all_(N *s, const N *src) \
+	{ \
+		N##_entry *e; \
+		container_size i, j; \
+		for (i=0; i<src->cap; ++i) { \
+			for (j=0; j<src->buckets[i].len; ++j) { \
+				e = &src->buckets[i].entries[j]; \
+				if (!N##_add_hashed_(s, e->key, e->hash)) return 0; \
+			} \
+		} \
+		return 1; \
+	} \
+	int N##_union_into(N *out, const N *a, const N *b) \
+	{ \
+		if (out != a && !N##_add_all_(out, a)) return 0; \
+		if (out != b && !N##_add_all_(out, b)) return 0; \
+		return 1; \
+	} \
+	int N##_intersect_into(N *out, const N *a, const N *b) \
+	{ \
+		const N *small, *large; \
+		N##_entry *e; \
+		container_size i, j; \
+		small = a->len < b->len ? a : b; \
+		large = small == a ? b : a; \
+		if (out == a || out == b) { \
+			/* remove the elements of out missing in the other set */ \
+			large = out == a ? b : a; \
+			N##_begin_removal_(out); \
+			for (i=0; i<out->cap; ++i) { \
+				for (j=0; j<out->buckets[i].len; ) { \
+					e = &out->buckets[i].entries[j]; \
+					if (N##_contains_hashed_(large, e->key, e->hash)) { \
+						++j; \
+					} else { \
+						N##_remove_hashed_(out, e->key, e->hash); \
+					} \
+				} \
+			} \
+			N##_end_removal_(out); \
+			return 1; \
+		} \
+		for (i=0; i<small->cap; ++i) { \
+			for (j=0; j<small->buckets[i].len; ++j) { \
+				e = &small->buckets[i].entries[j]; \
+				if (N##_contains_hashed_(large, e->key, e->hash) && !N##_add_hashed_(out, e->key, e->hash)) return 0; \
+			} \
+		} \
+		return 1; \
+	} \
+	int N##_difference_into(N *out, const N *a, const N *b) \
+	{ \
+		N##_entry *e; \
+		container_size i, j; \
+		N tmp; \
+		if (out == b) { \
+			/* b is needed until the end, build the result separately */ \
+			if (!N##_init_cap(&tmp, out->cap)) return 0; \
+			tmp.max_load = out->max_load; \
+			tmp.min_load = out->min_load; \
+			if (!N##_difference_into(&tmp, a, b)) { \
+				N##_destroy(&tmp); \
+				return 0; \
+			} \
+			N##_destroy(out); \
+			*out = tmp; \
+			return 1; \
+		} \
+		if (out == a) { \
+			N##_begin_removal_(out); \
+		} \
+		if (out == a && b->len < a->len) { \
+			for (i=0; i<b->cap; ++i) { \
+				for (j=0; j<b->buckets[i].len; ++j) { \
+					e = &b->buckets[i].entries[j]; \
+					N##_remove_hashed_(out, e->key, e->hash); \
+				} \
+			} \
+			N##_end_removal_(out); \
+			return 1; \
+		} \
+		for (i=0; i<a->cap; ++i) { \
+			for (j=0; j<a->buckets[i].len; ) { \
+				e = &a->buckets[i].entries[j]; \
+				if (!N##_contains_hashed_(b, e->key, e->hash)) { \
+					if (out != a && !N##_add_hashed_(out, e->key, e->hash)) return 0; \
+					++j; \
+				} else if (out == a) { \
+					N##_remove_hashed_(out, e->key, e->hash); \
+				} else { \
+					++j; \
+				} \
+			} \
+		} \
+		if (out == a) { \
+			N##_end_removal_(out); \
+		} \
+		return 1; \
+	} \
+	N##_iterator N##_iterate(const N *s) \
+	{ \
+		N##_iterator iter; \
+		iter.bucket = 0; \
+		iter.entry = -1; \
+		return iter; \
+	} \
+	int N##_next(const N *s, N##_iterator *iter) \
+	{ \
+		container_size i; \
+		if (iter->entry+1 < s->buckets[iter->bucket].len) { \
+			++iter->entry; \
+			return 1; \
+		} \
+		for (i=iter->bucket+1; i<s->cap; ++i) { \
+			if (s->buckets[i].len > 0) { \
+				iter->bucket = i; \
+				iter->entry = 0; \
+				return 1; \
+			} \
+		} \
+		return 0; \
+	} \
+	K N##_key_at(const N *s, N##_iterator iter) \
+	{ \
+		return s->buckets[iter.bucket].entries[iter.entry].key; \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+#endif /* ifndef HSET_H_INCLUDED */
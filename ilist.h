@@ -0,0 +1,131 @@
+/* ilist.h: a CPP-based template implementation of intrusive doubly-linked list */
+
+#ifndef ILIST_H_INCLUDED
+#define ILIST_H_INCLUDED 1
+
+#include <stddef.h>
+#include "container.h"
+
+/* the links of an element, a field of the element struct for each list it can be in */
+typedef struct ilist_link ilist_link;
+struct ilist_link { ilist_link *prev; ilist_link *next; };
+
+#define ILIST_PROTO(TYPE, N) \
+	typedef struct N N; \
+	typedef TYPE *N##_iterator; \
+	void N##_init(N *s); \
+	container_size N##_size(const N *s); \
+	TYPE *N##_get(const N *s, container_size pos); \
+	TYPE *N##_pop(N *s, container_size pos); \
+	N##_iterator N##_iterate(const N *s); \
+	int N##_next(const N *s, N##_iterator *iter); \
+	int N##_prev(const N *s, N##_iterator *iter); \
+	TYPE *N##_get_at(const N *s, N##_iterator iter); \
+	void N##_link(N *s, TYPE *item, N##_iterator iter); \
+	void N##_unlink(N *s, TYPE *item); \
+	void N##_splice(N *s, N##_iterator iter, N *other)
+
+/*
+ * defines functions for a list named N of TYPE structs, which are linked by
+ * their ilist_link field MEMBER, so the list never allocates or copies them
+ */
+#define ILIST(TYPE, MEMBER, N) \
+	struct N { container_size len; ilist_link *first; ilist_link *last; }; \
+	/* the element of link l or NULL */ \
+	TYPE *N##_item_(const ilist_link *l) \
+	{ \
+		return l ? CONTAINER_OF(l, TYPE, MEMBER) : NULL; \
+	} \
+	void N##_init(N *s) \
+	{ \
+		s->len = 0; \
+		s->first = NULL; \
+		s->last = NULL; \
+	} \
+	container_size N##_size(const N *s) \
+	{ \
+		return s->len; \
+	} \
+	/* returns the element at pos, walking from the nearer end of the list */ \
+	TYPE *N##_get(const N *s, container_size pos) \
+	{ \
+		ilist_link *l; \
+		container_size i; \
+		if (pos < 0) return N##_item_(s->last); \
+		if (pos < s->len/2) { \
+			for (l=s->first, i=0; i<pos; ++i) l=l->next; \
+		} else { \
+			for (l=s->last, i=s->len-1; i>pos; --i) l=l->prev; \
+		} \
+		return N##_item_(l); \
+	} \
+	/* unlinks the element at pos and returns it, NULL if the list is empty */ \
+	TYPE *N##_pop(N *s, container_size pos) \
+	{ \
+		TYPE *item; \
+		if (!s->len) return NULL; \
+		item = N##_get(s, pos); \
+		N##_unlink(s, item); \
+		return item; \
+	} \
+	N##_iterator N##_iterate(const N *s) \
+	{ \
+		return NULL; \
+	} \
+	int N##_next(const N *s, N##_iterator *iter) \
+	{ \
+		*iter = N##_item_(*iter ? (*iter)->MEMBER.next : s->first); \
+		return *iter != NULL; \
+	} \
+	int N##_prev(const N *s, N##_iterator *iter) \
+	{ \
+		*iter = N##_item_(*iter ? (*iter)->MEMBER.prev : s->last); \
+		return *iter != NULL; \
+	} \
+	TYPE *N##_get_at(const N *s, N##_iterator iter) \
+	{ \
+		return iter; \
+	} \
+	/* links item before iter, or to the tail if iter is NULL */ \
+	void N##_link(N *s, TYPE *item, N##_iterator iter) \
+	{ \
+		ilist_link *l, *at; \
+		l = &item->MEMBER; \
+		at = iter ? &iter->MEMBER : NULL; \
+		l->next = at; \
+		l->prev = at ? at->prev : s->last; \
+		if (l->prev) l->prev->next = l; \
+		else s->first = l; \
+		if (at) at->prev = l; \
+		else s->last = l; \
+		++s->len; \
+	} \
+	void N##_unlink(N *s, TYPE *item) \
+	{ \
+		ilist_link *l; \
+		l = &item->MEMBER; \
+		if (l->prev) l->prev->next = l->next; \
+		else s->first = l->next; \
+		if (l->next) l->next->prev = l->prev; \
+		else s->last = l->prev; \
+		l->prev = l->next = NULL; \
+		--s->len; \
+	} \
+	/* moves all elements of other before iter (to the tail if NULL) */ \
+	void N##_splice(N *s, N##_iterator iter, N *other) \
+	{ \
+		ilist_link *at; \
+		if (!other->first) return; \
+		at = iter ? &iter->MEMBER : NULL; \
+		other->last->next = at; \
+		other->first->prev = at ? at->prev : s->last; \
+		if (other->first->prev) other->first->prev->next = other->first; \
+		else s->first = other->first; \
+		if (at) at->prev = other->last; \
+		else s->last = other->last; \
+		s->len += other->len; \
+		N##_init(other); \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+#endif /* ifndef ILIST_H_INCLUDED */
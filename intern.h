@@ -0,0 +1,218 @@
+/* intern.h: a CPP-based template implementation of a string interning map */
+
+#ifndef INTERN_H_INCLUDED
+#define INTERN_H_INCLUDED 1
+
+#include "hmap.h"
+
+#define INTERN_CHUNK_SIZE 65536 /* bytes per arena chunk, longer strings get a chunk of their own */
+/* the alignment of the string headers */
+#define INTERN_ALIGN_ (sizeof(container_hash) > sizeof(container_size) ? sizeof(container_hash) : sizeof(container_size))
+
+/* the offset basis and prime of FNV-1a for the width of container_hash */
+#ifdef CONTAINER_HASH64
+#define INTERN_FNV_BASIS_ UINT64_C(14695981039346656037)
+#define INTERN_FNV_PRIME_ UINT64_C(1099511628211)
+#else
+#define INTERN_FNV_BASIS_ 2166136261u
+#define INTERN_FNV_PRIME_ 16777619u
+#endif
+
+#define INTERN_PROTO(V, N) \
+	HMAP_PROTO(hmap_strview, V, N##_map); \
+	typedef struct N##_chunk N##_chunk; \
+	typedef struct N##_header_ N##_header_; \
+	typedef struct N N; \
+	typedef N##_map_iterator N##_iterator; \
+	N *N##_new(void); \
+	void N##_free(N *m); \
+	int N##_init(N *m); \
+	void N##_destroy(N *m); \
+	container_size N##_size(const N *m); \
+	const char *N##_intern(N *m, const char *str, size_t len); \
+	size_t N##_strlen(const char *interned); \
+	container_hash N##_strhash(const char *interned); \
+	int N##_get(const N *m, const char *str, size_t len, V *value); \
+	V *N##_get_ref(N *m, const char *str, size_t len); \
+	int N##_set(N *m, const char *str, size_t len, V value); \
+	V *N##_upsert(N *m, const char *str, size_t len, int *inserted); \
+	N##_iterator N##_iterate(const N *m); \
+	int N##_next(const N *m, N##_iterator *iter); \
+	const char *N##_key_at(const N *m, N##_iterator iter); \
+	V N##_value_at(const N *m, N##_iterator iter)
+
+/*
+ * defines a map from strings to V named N, which copies its keys into an arena
+ * of large chunks owned by the map; each string is stored once, null-terminated
+ * and preceded by its hash and length, and stays at the same address until the
+ * map is freed, so the pointers returned by N##_intern can be compared instead
+ * of the strings; strings can't be removed from the map, freeing the map frees
+ * all of them at once
+ */
+#define INTERN(V, N) \
+	/* FNV-1a */ \
+	container_hash N##_view_hash_(hmap_strview key) \
+	{ \
+		container_hash hash; \
+		size_t i; \
+		hash = INTERN_FNV_BASIS_; \
+		for (i=0; i<key.len; ++i) { \
+			hash ^= (unsigned char)key.str[i]; \
+			hash *= INTERN_FNV_PRIME_; \
+		} \
+		return hash; \
+	} \
+	HMAP(hmap_strview, V, N##_map, hmap_strview_cmp, N##_view_hash_); \
+	struct N##_chunk { N##_chunk *next; size_t used; size_t cap; }; \
+	struct N##_header_ { container_hash hash; container_size len; }; \
+	struct N { N##_map map; N##_chunk *chunks; }; \
+	N *N##_new(void) \
+	{ \
+		N *m; \
+		m = CONTAINER_MALLOC(sizeof(struct N)); \
+		if (!m) return NULL; \
+		if (!N##_init(m)) { \
+			CONTAINER_FREE(m); \
+			return NULL; \
+		} \
+		return m; \
+	} \
+	void N##_free(N *m) \
+	{ \
+		N##_destroy(m); \
+		CONTAINER_FREE(m); \
+	} \
+	int N##_init(N *m) \
+	{ \
+		m->chunks = NULL; \
+		return N##_map_init(&m->map); \
+	} \
+	void N##_destroy(N *m) \
+	{ \
+		N##_chunk *c, *next; \
+		for (c=m->chunks; c; c=next) { \
+			next = c->next; \
+			CONTAINER_FREE(c); \
+		} \
+		N##_map_destroy(&m->map); \
+	} \
+	container_size N##_size(const N *m) \
+	{ \
+		return N##_map_size(&m->map); \
+	} \
+	/* copies the string to the arena, returns the copy or NULL */ \
+	const char *N##_store_(N *m, const char *str, size_t len, container_hash hash) \
+	{ \
+		N##_chunk *c; \
+		N##_header_ *header; \
+		char *copy; \
+		size_t size, cap; \
+		/* the header, the string, the terminating null and padding to align the next header */ \
+		size = sizeof(struct N##_header_) + (len + INTERN_ALIGN_) / INTERN_ALIGN_ * INTERN_ALIGN_; \
+		c = m->chunks; \
+		if (!c || c->cap - c->used < size) { \
+			cap = size > INTERN_CHUNK_SIZE ? size : INTERN_CHUNK_SIZE; \
+			c = CONTAINER_MALLOC(sizeof(struct N##_chunk) + cap); \
+			if (!c) return NULL; \
+			c->used = 0; \
+			c->cap = cap; \
+			if (size > INTERN_CHUNK_SIZE && m->chunks) { \
+				/* keep filling the current chunk */ \
+				c->next = m->chunks->next; \
+				m->chunks->next = c; \
+			} else { \
+				c->next = m->chunks; \
+				m->chunks = c; \
+			} \
+		} \
+		header = (N##_header_ *)((char *)(c + 1) + c->used); \
+		header->hash = hash; \
+		header->len = len; \
+		copy = (char *)(header + 1); \
+		memcpy(copy, str, len); \
+		copy[len] = '\0'; \
+		c->used += size; \
+		return copy; \
+	} \
+	/* returns the entry of the string, adding it with a zeroed value if it's missing */ \
+	N##_map_entry *N##_lookup_add_(N *m, const char *str, size_t len, int *inserted) \
+	{ \
+		N##_map_entry *entry; \
+		hmap_strview key; \
+		container_hash hash; \
+		key.len = len; \
+		key.str = str; \
+		hash = N##_view_hash_(key); \
+		entry = N##_map_find_(&m->map, key, hash); \
+		if (entry) { \
+			if (inserted) *inserted = 0; \
+			return entry; \
+		} \
+		if (len > CONTAINER_SIZE_MAX) return NULL; \
+		key.str = N##_store_(m, str, len, hash); \
+		if (!key.str) return NULL; \
+		entry = N##_map_add_(&m->map, key, hash, NULL); \
+		if (entry && inserted) *inserted = 1; \
+		return entry; \
+	} \
+	const char *N##_intern(N *m, const char *str, size_t len) \
+	{ \
+		N##_map_entry *entry; \
+		entry = N##_lookup_add_(m, str, len, NULL); \
+		return entry ? entry->key.str : NULL; \
+	} \
+	size_t N##_strlen(const char *interned) \
+	{ \
+		return ((const N##_header_ *)interned - 1)->len; \
+	} \
+	container_hash N##_strhash(const char *interned) \
+	{ \
+		return ((const N##_header_ *)interned - 1)->hash; \
+	} \
+	int N##_get(const N *m, const char *str, size_t len, V *value) \
+	{ \
+		hmap_strview key; \
+		key.len = len; \
+		key.str = str; \
+		return N##_map_get_contains(&m->map, key, value); \
+	} \
+	V *N##_get_ref(N *m, const char *str, size_t len) \
+	{ \
+		hmap_strview key; \
+		key.len = len; \
+		key.str = str; \
+		return N##_map_get_ref(&m->map, key); \
+	} \
+	int N##_set(N *m, const char *str, size_t len, V value) \
+	{ \
+		N##_map_entry *entry; \
+		entry = N##_lookup_add_(m, str, len, NULL); \
+		if (!entry) return 0; \
+		entry->value = value; \
+		return 1; \
+	} \
+	V *N##_upsert(N *m, const char *str, size_t len, int *inserted) \
+	{ \
+		N##_map_entry *entry; \
+		entry = N##_lookup_add_(m, str, len, inserted); \
+		return entry ? &entry->value : NULL; \
+	} \
+	N##_iterator N##_iterate(const N *m) \
+	{ \
+		return N##_map_iterate(&m->map); \
+	} \
+	int N##_next(const N *m, N##_iterator *iter) \
+	{ \
+		return N##_map_next(&m->map, iter); \
+	} \
+	const char *N##_key_at(const N *m, N##_iterator iter) \
+	{ \
+		return N##_map_key_at(&m->map, iter).str; \
+	} \
+	V N##_value_at(const N *m, N##_iterator iter) \
+	{ \
+		return N##_map_value_at(&m->map, iter); \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+#endif /* ifndef INTERN_H_INCLUDED */
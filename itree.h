@@ -0,0 +1,250 @@
+/* itree.h: a CPP-based template implementation of intrusive AVL tree */
+
+#ifndef ITREE_H_INCLUDED
+#define ITREE_H_INCLUDED 1
+
+#include <stddef.h>
+#include "container.h"
+
+/* the links of an element, a field of the element struct for each tree it can be in */
+typedef struct itree_link itree_link;
+struct itree_link { itree_link *parent; itree_link *left; itree_link *right; int height; };
+
+#define ITREE_PROTO(TYPE, N) \
+	typedef struct N N; \
+	typedef TYPE *N##_iterator; \
+	void N##_init(N *s); \
+	container_size N##_size(const N *s); \
+	TYPE *N##_insert(N *s, TYPE *item); \
+	void N##_remove(N *s, TYPE *item); \
+	TYPE *N##_find(const N *s, const TYPE *key); \
+	TYPE *N##_lower_bound(const N *s, const TYPE *key); \
+	TYPE *N##_first(const N *s); \
+	TYPE *N##_last(const N *s); \
+	N##_iterator N##_iterate(const N *s); \
+	int N##_next(const N *s, N##_iterator *iter); \
+	int N##_prev(const N *s, N##_iterator *iter); \
+	TYPE *N##_get_at(const N *s, N##_iterator iter)
+
+/*
+ * defines functions for an AVL tree named N of TYPE structs, which are linked
+ * by their itree_link field MEMBER, so the tree never allocates or copies
+ * them; int CMP(const TYPE *a, const TYPE *b) orders them like the compare
+ * functions of hmap and is expanded in the generated code
+ */
+#define ITREE(TYPE, MEMBER, N, CMP) \
+	struct N { container_size len; itree_link *root; }; \
+	/* the element of link l or NULL */ \
+	TYPE *N##_item_(const itree_link *l) \
+	{ \
+		return l ? CONTAINER_OF(l, TYPE, MEMBER) : NULL; \
+	} \
+	int N##_height_(const itree_link *l) \
+	{ \
+		return l ? l->height : 0; \
+	} \
+	void N##_update_(itree_link *l) \
+	{ \
+		int lh, rh; \
+		lh = N##_height_(l->left); \
+		rh = N##_height_(l->right); \
+		l->height = (lh > rh ? lh : rh) + 1; \
+	} \
+	/* puts new in the place of old under parent */ \
+	void N##_replace_(N *s, itree_link *parent, itree_link *old, itree_link *new_) \
+	{ \
+		if (!parent) s->root = new_; \
+		else if (parent->left == old) parent->left = new_; \
+		else parent->right = new_; \
+		if (new_) new_->parent = parent; \
+	} \
+	itree_link *N##_rotate_left_(N *s, itree_link *x) \
+	{ \
+		itree_link *y; \
+		y = x->right; \
+		x->right = y->left; \
+		if (y->left) y->left->parent = x; \
+		N##_replace_(s, x->parent, x, y); \
+		y->left = x; \
+		x->parent = y; \
+		N##_update_(x); \
+		N##_update_(y); \
+		return y; \
+	} \
+	itree_link *N##_rotate_right_(N *s, itree_link *x) \
+	{ \
+		itree_link *y; \
+		y = x->left; \
+		x->left = y->right; \
+		if (y->right) y->right->parent = x; \
+		N##_replace_(s, x->parent, x, y); \
+		y->right = x; \
+		x->parent = y; \
+		N##_update_(x); \
+		N##_update_(y); \
+		return y; \
+	} \
+	/* restores the heights and the balance from l up to the root */ \
+	void N##_rebalance_(N *s, itree_link *l) \
+	{ \
+		int balance; \
+		for (; l; l=l->parent) { \
+			N##_update_(l); \
+			balance = N##_height_(l->left) - N##_height_(l->right); \
+			if (balance > 1) { \
+				if (N##_height_(l->left->left) < N##_height_(l->left->right)) { \
+					N##_rotate_left_(s, l->left); \
+				} \
+				l = N##_rotate_right_(s, l); \
+			} else if (balance < -1) { \
+				if (N##_height_(l->right->right) < N##_height_(l->right->left)) { \
+					N##_rotate_right_(s, l->right); \
+				} \
+				l = N##_rotate_left_(s, l); \
+			} \
+		} \
+	} \
+	void N##_init(N *s) \
+	{ \
+		s->len = 0; \
+		s->root = NULL; \
+	} \
+	container_size N##_size(const N *s) \
+	{ \
+		return s->len; \
+	} \
+	/* links item into the tree, returns NULL or an equal element already in it */ \
+	TYPE *N##_insert(N *s, TYPE *item) \
+	{ \
+		itree_link *l, *parent, **p; \
+		int c; \
+		parent = NULL; \
+		for (p=&s->root; *p; ) { \
+			parent = *p; \
+			c = CMP(item, N##_item_(parent)); \
+			if (!c) return N##_item_(parent); \
+			p = c < 0 ? &parent->left : &parent->right; \
+		} \
+		l = &item->MEMBER; \
+		l->parent = parent; \
+		l->left = l->right = NULL; \
+		l->height = 1; \
+		*p = l; \
+		++s->len; \
+		N##_rebalance_(s, parent); \
+		return NULL; \
+	} \
+	/* unlinks item, which must be in the tree, without comparing any elements */ \
+	void N##_remove(N *s, TYPE *item) \
+	{ \
+		itree_link *l, *y, *start; \
+		l = &item->MEMBER; \
+		if (l->left && l->right) { \
+			/* put the successor, which has no left child, in the place of l */ \
+			for (y=l->right; y->left; y=y->left); \
+			if (y->parent == l) { \
+				start = y; \
+			} else { \
+				start = y->parent; \
+				start->left = y->right; \
+				if (y->right) y->right->parent = start; \
+				y->right = l->right; \
+				y->right->parent = y; \
+			} \
+			y->left = l->left; \
+			y->left->parent = y; \
+			N##_replace_(s, l->parent, l, y); \
+		} else { \
+			start = l->parent; \
+			N##_replace_(s, l->parent, l, l->left ? l->left : l->right); \
+		} \
+		--s->len; \
+		N##_rebalance_(s, start); \
+	} \
+	TYPE *N##_find(const N *s, const TYPE *key) \
+	{ \
+		itree_link *l; \
+		int c; \
+		for (l=s->root; l; ) { \
+			c = CMP(key, N##_item_(l)); \
+			if (!c) return N##_item_(l); \
+			l = c < 0 ? l->left : l->right; \
+		} \
+		return NULL; \
+	} \
+	/* returns the first element not less than key, NULL if there's none */ \
+	TYPE *N##_lower_bound(const N *s, const TYPE *key) \
+	{ \
+		itree_link *l, *found; \
+		found = NULL; \
+		for (l=s->root; l; ) { \
+			if (CMP(key, N##_item_(l)) <= 0) { \
+				found = l; \
+				l = l->left; \
+			} else { \
+				l = l->right; \
+			} \
+		} \
+		return N##_item_(found); \
+	} \
+	TYPE *N##_first(const N *s) \
+	{ \
+		itree_link *l; \
+		if (!s->root) return NULL; \
+		for (l=s->root; l->left; l=l->left); \
+		return N##_item_(l); \
+	} \
+	TYPE *N##_last(const N *s) \
+	{ \
+		itree_link *l; \
+		if (!s->root) return NULL; \
+		for (l=s->root; l->right; l=l->right); \
+		return N##_item_(l); \
+	} \
+	N##_iterator N##_iterate(const N *s) \
+	{ \
+		return NULL; \
+	} \
+	/* moves iter to the next element in order, from a new iterator to the first one */ \
+	int N##_next(const N *s, N##_iterator *iter) \
+	{ \
+		itree_link *l; \
+		if (!*iter) { \
+			*iter = N##_first(s); \
+			return *iter != NULL; \
+		} \
+		l = &(*iter)->MEMBER; \
+		if (l->right) { \
+			for (l=l->right; l->left; l=l->left); \
+		} else { \
+			while (l->parent && l->parent->right == l) l = l->parent; \
+			l = l->parent; \
+		} \
+		*iter = N##_item_(l); \
+		return *iter != NULL; \
+	} \
+	/* moves iter to the previous element in order, from a new iterator to the last one */ \
+	int N##_prev(const N *s, N##_iterator *iter) \
+	{ \
+		itree_link *l; \
+		if (!*iter) { \
+			*iter = N##_last(s); \
+			return *iter != NULL; \
+		} \
+		l = &(*iter)->MEMBER; \
+		if (l->left) { \
+			for (l=l->left; l->right; l=l->right); \
+		} else { \
+			while (l->parent && l->parent->left == l) l = l->parent; \
+			l = l->parent; \
+		} \
+		*iter = N##_item_(l); \
+		return *iter != NULL; \
+	} \
+	TYPE *N##_get_at(const N *s, N##_iterator iter) \
+	{ \
+		return iter; \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+#endif /* ifndef ITREE_H_INCLUDED */
@@ -4,6 +4,7 @@
 #define LLIST_H_INCLUDED 1
 
 #include <stdlib.h>
+#include "container.h"
 
 #define LLIST_PROTO(T, N) \
 	typedef struct N##_pair N##_pair; \
@@ -11,12 +12,14 @@
 	typedef struct N##_iterator N##_iterator; \
 	N *N##_new(void); \
 	void N##_free(N *s); \
+	int N##_init(N *s); \
+	void N##_destroy(N *s); \
 	N##_pair *N##_pair_new(T item); \
-	int N##_size(const N *s); \
-	int N##_insert(N *s, T item, int pos); \
-	T N##_pop(N *s, int pos); \
-	T N##_get(const N *s, int pos); \
-	void N##_set(N *s, T item, int pos); \
+	container_size N##_size(const N *s); \
+	int N##_insert(N *s, T item, container_size pos); \
+	T N##_pop(N *s, container_size pos); \
+	T N##_get(const N *s, container_size pos); \
+	void N##_set(N *s, T item, container_size pos); \
 	N##_iterator N##_iterate(const N *s); \
 	int N##_next(const N *s, N##_iterator *iter); \
 	T N##_get_at(const N *s, N##_iterator iter); \
@@ -25,46 +28,66 @@
 	T N##_pop_at(N *s, N##_iterator iter)
 
 #define LLIST(T, N) \
+	LLIST_STRUCT(T, N); \
+	LLIST_FUNCTIONS(T, N)
+
+/*
+ * LLIST split in two: LLIST_STRUCT defines the structs, so they can go in a
+ * header after LLIST_PROTO for a list embedded by value in another struct, and
+ * LLIST_FUNCTIONS then defines the functions in one .c file
+ */
+#define LLIST_STRUCT(T, N) \
 	struct N##_pair { T car; N##_pair *cdr; }; \
-	struct N { int len; N##_pair *first; N##_pair *last; }; \
-	struct N##_iterator { N##_pair *prev; N##_pair *curr; }; \
+	struct N { container_size len; N##_pair *first; N##_pair *last; }; \
+	struct N##_iterator { N##_pair *prev; N##_pair *curr; }
+
+#define LLIST_FUNCTIONS(T, N) \
 	N *N##_new(void) \
 	{ \
 		N *s; \
-		s = malloc(sizeof(struct N)); \
+		s = CONTAINER_MALLOC(sizeof(struct N)); \
 		if (!s) return NULL; \
+		N##_init(s); \
+		return s; \
+	} \
+	void N##_free(N *s) \
+	{ \
+		N##_destroy(s); \
+		CONTAINER_FREE(s); \
+	} \
+	int N##_init(N *s) \
+	{ \
 		s->len = 0; \
 		s->first = NULL; \
 		s->last = NULL; \
-		return s; \
+		return 1; \
 	} \
-	void N##_free(N *s) \
+	void N##_destroy(N *s) \
 	{ \
 		N##_pair *p, *temp; \
 		temp = NULL; \
 		for (p=s->first; p; ) { \
 			temp = p; \
 			p = p->cdr; \
-			free(temp); \
+			CONTAINER_FREE(temp); \
 		} \
-		free(s); \
 	} \
 	N##_pair *N##_pair_new(T item) \
 	{ \
 		N##_pair *p; \
-		p = malloc(sizeof(struct N##_pair)); \
+		p = CONTAINER_MALLOC(sizeof(struct N##_pair)); \
 		if (!p) return NULL; \
 		p->car = item; \
 		p->cdr = NULL; \
 		return p; \
 	} \
-	int N##_size(const N *s) \
+	container_size N##_size(const N *s) \
 	{ \
 		return s->len; \
 	} \
-	int N##_insert(N *s, T item, int pos) \
+	int N##_insert(N *s, T item, container_size pos) \
 	{ \
-		int i; \
+		container_size i; \
 		N##_pair *newp, *p; \
 		newp = N##_pair_new(item); \
 		if (!newp) return 0; \
@@ -87,7 +110,7 @@
 		} \
 		for (p=s->first, i=0; i<pos-1 && p; ++i) p=p->cdr; \
 		if (!p) { \
-			free(newp); \
+			CONTAINER_FREE(newp); \
 			return 0; \
 		} \
 		newp->cdr = p->cdr; \
@@ -98,23 +121,24 @@
 		} \
 		return 1; \
 	} \
-	T N##_pop(N *s, int pos) \
+	T N##_pop(N *s, container_size pos) \
 	{ \
 		N##_pair *p, *p2; \
 		T temp; \
-		int i; \
+		container_size i; \
+		if (pos < 0) { \
+			pos = s->len - 1; \
+		} \
 		if (pos == 0) { \
 			p = s->first; \
 			s->first = p->cdr; \
 			temp = p->car; \
 			if (!p->cdr) s->last = NULL; \
-			free(p); \
+			CONTAINER_FREE(p); \
 			--s->len; \
 			return temp; \
 		} \
-		if (pos < 0) { \
-			pos = s->len - 1; \
-		} \
+		/* singly-linked, so popping the tail needs to find its predecessor */ \
 		for (p=s->first, i=0; i<pos-1 && p; ++i) p=p->cdr; \
 		temp = p->cdr->car; \
 		p2 = p->cdr; \
@@ -122,13 +146,13 @@
 		if (!p->cdr) { \
 			s->last = p; \
 		} \
-		free(p2); \
+		CONTAINER_FREE(p2); \
 		--s->len; \
 		return temp; \
 	} \
-	T N##_get(const N *s, int pos) \
+	T N##_get(const N *s, container_size pos) \
 	{ \
-		int i; \
+		container_size i; \
 		N##_pair *p; \
 		if (pos == 0) { \
 			return s->first->car; \
@@ -139,9 +163,9 @@
 		for (p=s->first, i=0; i<pos && p; ++i) p=p->cdr; \
 		return p->car; \
 	} \
-	void N##_set(N *s, T item, int pos) \
+	void N##_set(N *s, T item, container_size pos) \
 	{ \
-		int i; \
+		container_size i; \
 		N##_pair *p; \
 		if (pos == 0) { \
 			s->first->car = item; \
@@ -161,7 +185,7 @@
 	{ \
 		if (!iter->curr) { \
 			iter->curr = s->first; \
-			return 1; \
+			return iter->curr != NULL; \
 		} \
 		if (!iter->curr->cdr) { \
 			return 0; \
@@ -190,6 +214,9 @@
 		} else { \
 			iter.prev->cdr = newp; \
 		} \
+		if (!newp->cdr) { \
+			s->last = newp; \
+		} \
 		return 1; \
 	} \
 	T N##_pop_at(N *s, N##_iterator iter) \
@@ -203,7 +230,7 @@
 		} \
 		if (s->last == iter.curr) s->last = iter.prev; \
 		val = iter.curr->car; \
-		free(iter.curr); \
+		CONTAINER_FREE(iter.curr); \
 		return val; \
 	} \
 	struct N /* to avoid extra semicolon outside of a function */
@@ -0,0 +1,319 @@
+/* lru.h: CPP-based template implementations of bounded caches */
+
+#ifndef LRU_H_INCLUDED
+#define LRU_H_INCLUDED 1
+
+#include <stdlib.h>
+#include <string.h>
+#include "container.h"
+
+#define LRU_CACHE_PROTO(K, V, N) \
+	typedef struct N##_node N##_node; \
+	typedef struct N N; \
+	typedef container_size N##_iterator; \
+	N *N##_new(void); \
+	void N##_free(N *c); \
+	int N##_init(N *c); \
+	void N##_destroy(N *c); \
+	container_size N##_size(const N *c); \
+	int N##_get(N *c, K key, V *value); \
+	V *N##_get_ref(N *c, K key); \
+	int N##_peek(const N *c, K key, V *value); \
+	int N##_contains(const N *c, K key); \
+	int N##_put(N *c, K key, V value); \
+	int N##_delete(N *c, K key); \
+	N##_iterator N##_iterate(const N *c); \
+	int N##_next(const N *c, N##_iterator *iter); \
+	K N##_key_at(const N *c, N##_iterator iter); \
+	V N##_value_at(const N *c, N##_iterator iter)
+
+/*
+ * defines a cache of at most CAPACITY entries mapping K to V named N, which
+ * evicts the least recently used entry to make room for a new one; C and H are
+ * the same as in HMAP; the entries are nodes of a pool allocated with the
+ * cache, linked into the chains of a hash index and into a doubly-linked
+ * recency list by their indices, so all operations are O(1) and never allocate
+ */
+#define LRU_CACHE(K, V, N, C, H, CAPACITY) \
+	struct N##_node { container_hash hash; container_size hnext; container_size prev; container_size next; K key; V value; }; \
+	struct N { \
+		container_size len; container_size used; container_size free_list; container_size mask; \
+		N##_node *nodes; container_size *buckets; container_size head; container_size tail; \
+		void (*on_evict)(K key, V value, void *ctx); void *evict_ctx; \
+	}; \
+	void N##_reset_order_(N *c) \
+	{ \
+		c->head = -1; \
+		c->tail = -1; \
+	} \
+	void N##_unlink_(N *c, container_size i) \
+	{ \
+		N##_node *node; \
+		node = &c->nodes[i]; \
+		if (node->prev >= 0) c->nodes[node->prev].next = node->next; \
+		else c->head = node->next; \
+		if (node->next >= 0) c->nodes[node->next].prev = node->prev; \
+		else c->tail = node->prev; \
+	} \
+	/* links node i as the most recently used */ \
+	void N##_link_(N *c, container_size i) \
+	{ \
+		N##_node *node; \
+		node = &c->nodes[i]; \
+		node->prev = -1; \
+		node->next = c->head; \
+		if (c->head >= 0) c->nodes[c->head].prev = i; \
+		else c->tail = i; \
+		c->head = i; \
+	} \
+	void N##_touch_(N *c, container_size i) \
+	{ \
+		if (c->head == i) return; \
+		N##_unlink_(c, i); \
+		N##_link_(c, i); \
+	} \
+	container_size N##_victim_(N *c) \
+	{ \
+		return c->tail; \
+	} \
+	/* iterates from the most to the least recently used entry */ \
+	N##_iterator N##_iterate(const N *c) \
+	{ \
+		return -1; \
+	} \
+	int N##_next(const N *c, N##_iterator *iter) \
+	{ \
+		*iter = *iter < 0 ? c->head : c->nodes[*iter].next; \
+		return *iter >= 0; \
+	} \
+	LRU_BODY_(K, V, N, C, H, CAPACITY)
+
+/* header entries for a CLOCK cache, same as LRU_CACHE_PROTO */
+#define CLOCK_CACHE_PROTO(K, V, N) \
+	LRU_CACHE_PROTO(K, V, N)
+
+/*
+ * same as LRU_CACHE, but evicts with the CLOCK algorithm, an approximation of
+ * LRU: a hit only sets the referenced flag of the entry instead of moving it
+ * in a list, and eviction sweeps the pool, clearing the flags, until it finds
+ * an entry which wasn't referenced since the last sweep; new entries start
+ * unreferenced, so a scan of keys used once doesn't flush the entries which
+ * are used repeatedly; the nodes are smaller and hits cheaper than with LRU
+ */
+#define CLOCK_CACHE(K, V, N, C, H, CAPACITY) \
+	struct N##_node { container_hash hash; container_size hnext; unsigned char ref; K key; V value; }; \
+	struct N { \
+		container_size len; container_size used; container_size free_list; container_size mask; \
+		N##_node *nodes; container_size *buckets; container_size hand; \
+		void (*on_evict)(K key, V value, void *ctx); void *evict_ctx; \
+	}; \
+	void N##_reset_order_(N *c) \
+	{ \
+		c->hand = 0; \
+	} \
+	/* free nodes are marked with LRU_FREE_ to skip them when iterating */ \
+	void N##_unlink_(N *c, container_size i) \
+	{ \
+		c->nodes[i].ref = LRU_FREE_; \
+	} \
+	void N##_link_(N *c, container_size i) \
+	{ \
+		c->nodes[i].ref = 0; \
+	} \
+	void N##_touch_(N *c, container_size i) \
+	{ \
+		c->nodes[i].ref = 1; \
+	} \
+	/* only called when the cache is full, so all nodes are in use */ \
+	container_size N##_victim_(N *c) \
+	{ \
+		container_size i; \
+		for (;;) { \
+			i = c->hand; \
+			c->hand = c->hand+1 < (CAPACITY) ? c->hand+1 : 0; \
+			if (!c->nodes[i].ref) return i; \
+			c->nodes[i].ref = 0; \
+		} \
+	} \
+	/* iterates in the order of the pool, which isn't the order of use */ \
+	N##_iterator N##_iterate(const N *c) \
+	{ \
+		return -1; \
+	} \
+	int N##_next(const N *c, N##_iterator *iter) \
+	{ \
+		while (++*iter < c->used) { \
+			if (c->nodes[*iter].ref != LRU_FREE_) return 1; \
+		} \
+		return 0; \
+	} \
+	LRU_BODY_(K, V, N, C, H, CAPACITY)
+
+#define LRU_FREE_ 2 /* the ref of free CLOCK_CACHE nodes */
+
+/*
+ * the functions shared by LRU_CACHE and CLOCK_CACHE; these need struct N and
+ * struct N##_node with the fields above and the functions keeping the order
+ * of eviction: N##_link_ adds a node, N##_unlink_ removes it, N##_touch_
+ * marks it used and N##_victim_ returns the node to evict
+ */
+#define LRU_BODY_(K, V, N, C, H, CAPACITY) \
+	container_hash N##_hash(K _lru_key) \
+	{ \
+		return H(_lru_key); \
+	} \
+	int N##_compare(K _lru_a, K _lru_b) \
+	{ \
+		return C(_lru_a, _lru_b); \
+	} \
+	N *N##_new(void) \
+	{ \
+		N *c; \
+		c = CONTAINER_MALLOC(sizeof(struct N)); \
+		if (!c) return NULL; \
+		if (!N##_init(c)) { \
+			CONTAINER_FREE(c); \
+			return NULL; \
+		} \
+		return c; \
+	} \
+	void N##_free(N *c) \
+	{ \
+		N##_destroy(c); \
+		CONTAINER_FREE(c); \
+	} \
+	int N##_init(N *c) \
+	{ \
+		container_size buckets; \
+		for (buckets=1; buckets<(CAPACITY); buckets*=2); \
+		/* the nodes and the buckets in one allocation */ \
+		c->nodes = CONTAINER_MALLOC((CAPACITY) * sizeof(struct N##_node) + buckets * sizeof(container_size)); \
+		if (!c->nodes) return 0; \
+		c->buckets = (container_size *)(c->nodes + (CAPACITY)); \
+		memset(c->buckets, 0xff, buckets * sizeof(container_size)); \
+		c->mask = buckets - 1; \
+		c->len = 0; \
+		c->used = 0; \
+		c->free_list = -1; \
+		c->on_evict = NULL; \
+		c->evict_ctx = NULL; \
+		N##_reset_order_(c); \
+		return 1; \
+	} \
+	void N##_destroy(N *c) \
+	{ \
+		CONTAINER_FREE(c->nodes); \
+	} \
+	container_size N##_size(const N *c) \
+	{ \
+		return c->len; \
+	} \
+	/* returns the index of the node with key or -1 */ \
+	container_size N##_find_(const N *c, K key, container_hash hash) \
+	{ \
+		container_size i; \
+		for (i=c->buckets[hash & c->mask]; i >= 0; i=c->nodes[i].hnext) { \
+			if (c->nodes[i].hash == hash && !N##_compare(c->nodes[i].key, key)) return i; \
+		} \
+		return -1; \
+	} \
+	/* removes node i from its hash chain */ \
+	void N##_unchain_(N *c, container_size i) \
+	{ \
+		container_size *p; \
+		for (p=&c->buckets[c->nodes[i].hash & c->mask]; *p != i; p=&c->nodes[*p].hnext); \
+		*p = c->nodes[i].hnext; \
+	} \
+	int N##_get(N *c, K key, V *value) \
+	{ \
+		container_size i; \
+		i = N##_find_(c, key, N##_hash(key)); \
+		if (i < 0) return 0; \
+		N##_touch_(c, i); \
+		if (value) { \
+			*value = c->nodes[i].value; \
+		} \
+		return 1; \
+	} \
+	V *N##_get_ref(N *c, K key) \
+	{ \
+		container_size i; \
+		i = N##_find_(c, key, N##_hash(key)); \
+		if (i < 0) return NULL; \
+		N##_touch_(c, i); \
+		return &c->nodes[i].value; \
+	} \
+	int N##_peek(const N *c, K key, V *value) \
+	{ \
+		container_size i; \
+		i = N##_find_(c, key, N##_hash(key)); \
+		if (i < 0) return 0; \
+		if (value) { \
+			*value = c->nodes[i].value; \
+		} \
+		return 1; \
+	} \
+	int N##_contains(const N *c, K key) \
+	{ \
+		return N##_find_(c, key, N##_hash(key)) >= 0; \
+	} \
+	int N##_put(N *c, K key, V value) \
+	{ \
+		N##_node *node; \
+		container_hash hash; \
+		container_size i; \
+		int evicted; \
+		hash = N##_hash(key); \
+		i = N##_find_(c, key, hash); \
+		if (i >= 0) { \
+			c->nodes[i].value = value; \
+			N##_touch_(c, i); \
+			return 0; \
+		} \
+		evicted = 0; \
+		if (c->free_list >= 0) { \
+			i = c->free_list; \
+			c->free_list = c->nodes[i].hnext; \
+		} else if (c->used < (CAPACITY)) { \
+			i = c->used++; \
+		} else { \
+			i = N##_victim_(c); \
+			N##_unlink_(c, i); \
+			N##_unchain_(c, i); \
+			--c->len; \
+			evicted = 1; \
+			if (c->on_evict) c->on_evict(c->nodes[i].key, c->nodes[i].value, c->evict_ctx); \
+		} \
+		node = &c->nodes[i]; \
+		node->hash = hash; \
+		node->key = key; \
+		node->value = value; \
+		node->hnext = c->buckets[hash & c->mask]; \
+		c->buckets[hash & c->mask] = i; \
+		N##_link_(c, i); \
+		++c->len; \
+		return evicted; \
+	} \
+	int N##_delete(N *c, K key) \
+	{ \
+		container_size i; \
+		i = N##_find_(c, key, N##_hash(key)); \
+		if (i < 0) return 0; \
+		N##_unlink_(c, i); \
+		N##_unchain_(c, i); \
+		c->nodes[i].hnext = c->free_list; \
+		c->free_list = i; \
+		--c->len; \
+		return 1; \
+	} \
+	K N##_key_at(const N *c, N##_iterator iter) \
+	{ \
+		return c->nodes[iter].key; \
+	} \
+	V N##_value_at(const N *c, N##_iterator iter) \
+	{ \
+		return c->nodes[iter].value; \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+#endif /* ifndef LRU_H_INCLUDED */
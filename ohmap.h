@@ -0,0 +1,343 @@
+/* ohmap.h: a CPP-based template implementation of an insertion-ordered hashmap */
+
+#ifndef OHMAP_H_INCLUDED
+#define OHMAP_H_INCLUDED 1
+
+#include <stdlib.h>
+#include <string.h>
+#include "container.h"
+
+#define OHMAP_MIN_CAP 8 /* minimum number of index slots, a power of two */
+#define OHMAP_DELETED ((container_hash)-1) /* the hash of deleted entries, live ones don't use the highest bit */
+
+#define HMAP_ORDERED_PROTO(K, V, N) \
+	typedef struct N##_entry N##_entry; \
+	typedef struct N N; \
+	typedef container_size N##_iterator; \
+	N *N##_new(void); \
+	N *N##_new_cap(container_size cap); \
+	void N##_free(N *map); \
+	int N##_init(N *map); \
+	int N##_init_cap(N *map, container_size cap); \
+	void N##_destroy(N *map); \
+	container_size N##_size(const N *map); \
+	int N##_resize(N *map, container_size cap); \
+	int N##_compact(N *map); \
+	V N##_get(const N *map, K key); \
+	int N##_contains(const N *map, K key); \
+	V N##_get_default(const N *map, K key, V def); \
+	int N##_get_contains(const N *map, K key, V *value); \
+	V *N##_get_ref(N *map, K key); \
+	int N##_set(N *map, K key, V value); \
+	V *N##_upsert(N *map, K key, int *inserted); \
+	int N##_delete(N *map, K key); \
+	int N##_take(N *map, K key, V *value); \
+	N##_iterator N##_iterate(const N *map); \
+	int N##_next(const N *map, N##_iterator *iter); \
+	K N##_key_at(const N *map, N##_iterator iter); \
+	V N##_value_at(const N *map, N##_iterator iter)
+
+/*
+ * defines functions for an insertion-ordered hashmap (like the dict of CPython)
+ * mapping K to V named N; C and H are the same as in HMAP; the entries are
+ * stored densely in insertion order and found through an open addressing table
+ * of 8, 16, 32 or 64-bit entry indices, whichever is enough for the capacity
+ */
+#define HMAP_ORDERED(K, V, N, C, H) \
+	struct N##_entry { container_hash hash; K key; V value; }; \
+	struct N { container_size len; container_size used; container_size cap; container_size index_cap; int index_width; N##_entry *entries; void *index; }; \
+	container_hash N##_hash(K _hmap_key) \
+	{ \
+		return H(_hmap_key) & OHMAP_DELETED >> 1; \
+	} \
+	int N##_compare(K _hmap_a, K _hmap_b) { \
+		return C(_hmap_a, _hmap_b); \
+	} \
+	const int N##_sizeof_value = sizeof(V); \
+	/* empty slots have all bits set, slots of deleted entries all but the lowest one */ \
+	size_t N##_slot_(const N *map, size_t i) \
+	{ \
+		switch (map->index_width) { \
+		case 1: \
+			return ((const uint8_t *)map->index)[i]; \
+		case 2: \
+			return ((const uint16_t *)map->index)[i]; \
+		case 4: \
+			return ((const uint32_t *)map->index)[i]; \
+		default: \
+			return ((const uint64_t *)map->index)[i]; \
+		} \
+	} \
+	void N##_set_slot_(N *map, size_t i, size_t value) \
+	{ \
+		switch (map->index_width) { \
+		case 1: \
+			((uint8_t *)map->index)[i] = value; \
+			break; \
+		case 2: \
+			((uint16_t *)map->index)[i] = value; \
+			break; \
+		case 4: \
+			((uint32_t *)map->index)[i] = value; \
+			break; \
+		default: \
+			((uint64_t *)map->index)[i] = value; \
+		} \
+	} \
+	size_t N##_empty_slot_(const N *map) \
+	{ \
+		return map->index_width >= (int)sizeof(size_t) ? (size_t)-1 : ((size_t)1 << 8*map->index_width) - 1; \
+	} \
+	/* rebuilds the map with index_cap slots (0 if that's too many), dropping deleted entries */ \
+	int N##_rebuild_(N *map, container_size index_cap) \
+	{ \
+		void *index; \
+		N##_entry *entries; \
+		size_t empty, i, mask; \
+		container_size cap, j, k; \
+		int width; \
+		width = index_cap <= 128 ? 1 : index_cap <= 32768 ? 2 : (size_t)index_cap <= 0xffffffffu ? 4 : 8; \
+		cap = index_cap/3*2; \
+		if (!index_cap || CONTAINER_OVERFLOWS(index_cap, width) || CONTAINER_OVERFLOWS(cap, sizeof(struct N##_entry))) return 0; \
+		index = CONTAINER_MALLOC((size_t)index_cap * width); \
+		if (!index) return 0; \
+		if (cap > map->cap) { \
+			entries = CONTAINER_REALLOC(map->entries, cap * sizeof(struct N##_entry)); \
+			if (!entries) { \
+				CONTAINER_FREE(index); \
+				return 0; \
+			} \
+			map->entries = entries; \
+		} \
+		for (j=0, k=0; j<map->used; ++j) { \
+			if (map->entries[j].hash != OHMAP_DELETED) map->entries[k++] = map->entries[j]; \
+		} \
+		if (cap < map->cap) { \
+			/* keeps the old allocation if this fails, it's larger */ \
+			entries = CONTAINER_REALLOC(map->entries, cap * sizeof(struct N##_entry)); \
+			if (entries) map->entries = entries; \
+		} \
+		CONTAINER_FREE(map->index); \
+		memset(index, 0xff, (size_t)index_cap * width); \
+		map->index = index; \
+		map->index_cap = index_cap; \
+		map->index_width = width; \
+		map->cap = cap; \
+		map->used = k; \
+		empty = N##_empty_slot_(map); \
+		mask = index_cap - 1; \
+		for (j=0; j<k; ++j) { \
+			for (i=map->entries[j].hash & mask; N##_slot_(map, i) != empty; i=(i+1) & mask); \
+			N##_set_slot_(map, i, j); \
+		} \
+		return 1; \
+	} \
+	/* the number of slots needed for cap entries, 0 if that's too many */ \
+	container_size N##_index_cap_(container_size cap) \
+	{ \
+		container_size index_cap; \
+		for (index_cap=OHMAP_MIN_CAP; index_cap/3*2 < cap; index_cap*=2) { \
+			if (index_cap > CONTAINER_SIZE_MAX/2) return 0; \
+		} \
+		return index_cap; \
+	} \
+	N *N##_new(void) \
+	{ \
+		return N##_new_cap(0); \
+	} \
+	N *N##_new_cap(container_size cap) \
+	{ \
+		N *map; \
+		map = CONTAINER_MALLOC(sizeof(struct N)); \
+		if (!map) return NULL; \
+		if (!N##_init_cap(map, cap)) { \
+			CONTAINER_FREE(map); \
+			return NULL; \
+		} \
+		return map; \
+	} \
+	void N##_free(N *map) \
+	{ \
+		N##_destroy(map); \
+		CONTAINER_FREE(map); \
+	} \
+	int N##_init(N *map) \
+	{ \
+		return N##_init_cap(map, 0); \
+	} \
+	int N##_init_cap(N *map, container_size cap) \
+	{ \
+		map->len = 0; \
+		map->used = 0; \
+		map->cap = 0; \
+		map->entries = NULL; \
+		map->index = NULL; \
+		if (!N##_rebuild_(map, N##_index_cap_(cap))) { \
+			CONTAINER_FREE(map->entries); \
+			return 0; \
+		} \
+		return 1; \
+	} \
+	void N##_destroy(N *map) \
+	{ \
+		CONTAINER_FREE(map->entries); \
+		CONTAINER_FREE(map->index); \
+	} \
+	container_size N##_size(const N *map) \
+	{ \
+		return map->len; \
+	} \
+	int N##_resize(N *map, container_size cap) \
+	{ \
+		return N##_rebuild_(map, N##_index_cap_(cap > map->len ? cap : map->len)); \
+	} \
+	int N##_compact(N *map) \
+	{ \
+		return N##_rebuild_(map, N##_index_cap_(map->len)); \
+	} \
+	/* returns the slot with key or the first free slot it would be inserted to as ~slot */ \
+	container_size N##_find_(const N *map, K key, container_hash hash) \
+	{ \
+		size_t i, mask, slot, empty; \
+		container_size free_slot; \
+		empty = N##_empty_slot_(map); \
+		mask = map->index_cap - 1; \
+		free_slot = -1; \
+		for (i=hash & mask; (slot = N##_slot_(map, i)) != empty; i=(i+1) & mask) { \
+			if (slot == empty - 1) { \
+				if (free_slot < 0) free_slot = i; \
+			} else if (map->entries[slot].hash == hash && !N##_compare(map->entries[slot].key, key)) { \
+				return i; \
+			} \
+		} \
+		return ~(free_slot < 0 ? (container_size)i : free_slot); \
+	} \
+	/* adds an entry for key, which isn't in the map, with value (zeroed if NULL); returns the new entry or NULL */ \
+	N##_entry *N##_add_(N *map, K key, container_hash hash, container_size slot, V const *value) \
+	{ \
+		N##_entry *entry; \
+		if (map->used == map->cap) { \
+			/* grow unless removing deleted entries frees enough space */ \
+			if (!N##_rebuild_(map, map->len*2 < map->cap ? map->index_cap : \
+					map->index_cap <= CONTAINER_SIZE_MAX/2 ? 2*map->index_cap : 0)) return NULL; \
+			slot = N##_find_(map, key, hash); \
+		} \
+		entry = &map->entries[map->used]; \
+		entry->hash = hash; \
+		entry->key = key; \
+		if (value) { \
+			entry->value = *value; \
+		} else { \
+			memset(&entry->value, 0, N##_sizeof_value); \
+		} \
+		N##_set_slot_(map, ~slot, map->used); \
+		++map->used; \
+		++map->len; \
+		return entry; \
+	} \
+	int N##_remove_(N *map, K key, V *value) \
+	{ \
+		container_size slot; \
+		size_t entry; \
+		slot = N##_find_(map, key, N##_hash(key)); \
+		if (slot < 0) return 0; \
+		entry = N##_slot_(map, slot); \
+		if (value) { \
+			*value = map->entries[entry].value; \
+		} \
+		map->entries[entry].hash = OHMAP_DELETED; \
+		N##_set_slot_(map, slot, N##_empty_slot_(map) - 1); \
+		--map->len; \
+		return 1; \
+	} \
+	V N##_get(const N *map, K key) \
+	{ \
+		V value; \
+		if (!N##_get_contains(map, key, &value)) { \
+			memset(&value, 0, N##_sizeof_value); \
+		} \
+		return value; \
+	} \
+	int N##_contains(const N *map, K key) \
+	{ \
+		return N##_find_(map, key, N##_hash(key)) >= 0; \
+	} \
+	V N##_get_default(const N *map, K key, V def) \
+	{ \
+		N##_get_contains(map, key, &def); \
+		return def; \
+	} \
+	int N##_get_contains(const N *map, K key, V *value) \
+	{ \
+		container_size slot; \
+		slot = N##_find_(map, key, N##_hash(key)); \
+		if (slot < 0) return 0; \
+		if (value) { \
+			*value = map->entries[N##_slot_(map, slot)].value; \
+		} \
+		return 1; \
+	} \
+	V *N##_get_ref(N *map, K key) \
+	{ \
+		container_size slot; \
+		slot = N##_find_(map, key, N##_hash(key)); \
+		return slot < 0 ? NULL : &map->entries[N##_slot_(map, slot)].value; \
+	} \
+	int N##_set(N *map, K key, V value) \
+	{ \
+		container_size slot; \
+		container_hash hash; \
+		hash = N##_hash(key); \
+		slot = N##_find_(map, key, hash); \
+		if (slot >= 0) { \
+			map->entries[N##_slot_(map, slot)].value = value; \
+			return 1; \
+		} \
+		return N##_add_(map, key, hash, slot, &value) != NULL; \
+	} \
+	V *N##_upsert(N *map, K key, int *inserted) \
+	{ \
+		N##_entry *entry; \
+		container_size slot; \
+		container_hash hash; \
+		hash = N##_hash(key); \
+		slot = N##_find_(map, key, hash); \
+		if (slot >= 0) { \
+			if (inserted) *inserted = 0; \
+			return &map->entries[N##_slot_(map, slot)].value; \
+		} \
+		entry = N##_add_(map, key, hash, slot, NULL); \
+		if (!entry) return NULL; \
+		if (inserted) *inserted = 1; \
+		return &entry->value; \
+	} \
+	int N##_delete(N *map, K key) \
+	{ \
+		return N##_remove_(map, key, NULL); \
+	} \
+	int N##_take(N *map, K key, V *value) \
+	{ \
+		return N##_remove_(map, key, value); \
+	} \
+	N##_iterator N##_iterate(const N *map) \
+	{ \
+		return -1; \
+	} \
+	int N##_next(const N *map, N##_iterator *iter) \
+	{ \
+		while (++*iter < map->used) { \
+			if (map->entries[*iter].hash != OHMAP_DELETED) return 1; \
+		} \
+		return 0; \
+	} \
+	K N##_key_at(const N *map, N##_iterator iter) \
+	{ \
+		return map->entries[iter].key; \
+	} \
+	V N##_value_at(const N *map, N##_iterator iter) \
+	{ \
+		return map->entries[iter].value; \
+	} \
+	struct N /* to avoid extra semicolon outside of a function */
+
+#endif /* ifndef OHMAP_H_INCLUDED */
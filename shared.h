@@ -0,0 +1,156 @@
+#ifndef SHARED_H_INCLUDED
+#define SHARED_H_INCLUDED 1
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "container.h"
+
+#define SHARED(T, N) \
+	/* The allocation of a shared value: its reference counts, its destructor
+	 * and the value itself. strong counts the owners, weak counts the weak
+	 * references plus one for all owners together, so the block is freed
+	 * when both are gone */ \
+	typedef struct N##_shared_block {\
+		atomic_size_t strong;\
+		atomic_size_t weak;\
+		void (*dtor)(T *data);\
+		T data;\
+	} N##_shared_block_t;\
+	\
+	/* An owning reference, a pointer to the value in the block */ \
+	typedef T *N##_shared_ptr_t;\
+	\
+	/* A weak reference, which doesn't keep the value alive and has to be
+	 * locked to get an owning reference */ \
+	typedef struct N##_weak {\
+		N##_shared_block_t *block;\
+	} N##_weak_t;\
+	\
+	static inline N##_shared_block_t *N##_shared_block( T *data ){\
+		return CONTAINER_OF( data, N##_shared_block_t, data );\
+	}\
+	\
+	/* Allocates a block holding value with one owner with CONTAINER_MALLOC;
+	 * dtor (if not NULL) is called with a pointer to the value when the last
+	 * owner releases it. Returns NULL on malloc failure */ \
+	static inline T *N##_make_shared( T value, void (*dtor)(T *data) ){\
+		N##_shared_block_t *block = CONTAINER_MALLOC( sizeof( N##_shared_block_t ));\
+		\
+		if ( !block ){\
+			return NULL;\
+		}\
+		\
+		atomic_init( &block->strong, 1 );\
+		atomic_init( &block->weak, 1 );\
+		block->dtor = dtor;\
+		block->data = value;\
+		\
+		return &block->data;\
+	}\
+	\
+	/* Adds an owner and returns data, to be handed to another owner or thread.
+	 * Relaxed, since the caller already owns a reference and so has the value */ \
+	static inline T *N##_retain( T *data ){\
+		if ( data ){\
+			atomic_fetch_add_explicit( &N##_shared_block( data )->strong, 1, memory_order_relaxed );\
+		}\
+		\
+		return data;\
+	}\
+	\
+	static inline void N##_weak_block_release( N##_shared_block_t *block ){\
+		if ( atomic_fetch_sub_explicit( &block->weak, 1, memory_order_acq_rel ) == 1 ){\
+			CONTAINER_FREE( block );\
+		}\
+	}\
+	\
+	/* Drops an owner. The last one calls the destructor, which sees all writes
+	 * of the other owners before they released the value (acq_rel), and frees
+	 * the block unless weak references are left */ \
+	static inline void N##_release( T *data ){\
+		N##_shared_block_t *block;\
+		\
+		if ( !data ){\
+			return;\
+		}\
+		\
+		block = N##_shared_block( data );\
+		if ( atomic_fetch_sub_explicit( &block->strong, 1, memory_order_acq_rel ) == 1 ){\
+			if ( block->dtor ){\
+				block->dtor( &block->data );\
+			}\
+			\
+			N##_weak_block_release( block );\
+		}\
+	}\
+	\
+	/* The number of owners, only a hint while other threads hold references */ \
+	static inline size_t N##_use_count( T *data ){\
+		return atomic_load_explicit(\
+			&N##_shared_block( data )->strong, memory_order_relaxed );\
+	}\
+	\
+	/* Returns a weak reference to the value of an owning reference */ \
+	static inline N##_weak_t N##_weak_ref( T *data ){\
+		N##_weak_t ret = { NULL };\
+		\
+		if ( data ){\
+			ret.block = N##_shared_block( data );\
+			atomic_fetch_add_explicit( &ret.block->weak, 1, memory_order_relaxed );\
+		}\
+		\
+		return ret;\
+	}\
+	\
+	/* Returns a new owning reference to the value of a weak reference, or NULL
+	 * if all owners have released it already */ \
+	static inline T *N##_lock( N##_weak_t w ){\
+		size_t strong;\
+		\
+		if ( !w.block ){\
+			return NULL;\
+		}\
+		\
+		strong = atomic_load_explicit( &w.block->strong, memory_order_relaxed );\
+		while ( strong > 0 ){\
+			if ( atomic_compare_exchange_weak_explicit( &w.block->strong, &strong, strong + 1,\
+						memory_order_acquire, memory_order_relaxed )){\
+				return &w.block->data;\
+			}\
+		}\
+		\
+		return NULL;\
+	}\
+	\
+	/* Drops a weak reference */ \
+	static inline void N##_weak_release( N##_weak_t *w ){\
+		if ( w->block ){\
+			N##_weak_block_release( w->block );\
+			w->block = NULL;\
+		}\
+	}\
+	\
+	/* Takes the reference out of a shared_t variable, which then won't release it */ \
+	static inline T *N##_shared_move( T **data ){\
+		T *ret = *data;\
+		\
+		*data = NULL;\
+		return ret;\
+	}\
+	\
+	/* The cleanup functions of shared_t and weak_t variables */ \
+	static inline void N##_shared_cleanup( T **data ){\
+		N##_release( *data );\
+		*data = NULL;\
+	}\
+	\
+	static inline void N##_weak_cleanup( N##_weak_t *w ){\
+		N##_weak_release( w );\
+	}
+
+#define _shared_(OUTTYPE) __attribute__((cleanup(OUTTYPE##_shared_cleanup)))
+#define shared_t(OUTTYPE) _shared_(OUTTYPE) OUTTYPE##_shared_ptr_t
+#define _weak_(OUTTYPE)   __attribute__((cleanup(OUTTYPE##_weak_cleanup)))
+#define weak_t(OUTTYPE)   _weak_(OUTTYPE) OUTTYPE##_weak_t
+
+#endif
@@ -4,6 +4,8 @@
 #define TREE_H_INCLUDED 1
 
 #include <stdlib.h>
+#include <string.h>
+#include "container.h"
 
 #define TREE_PROTO(T, N) \
 	typedef struct N N; \
@@ -17,9 +19,11 @@
 	struct N { T item; N *left; N *right; }; \
 	N *N##_new(T item) \
 	{ \
-		N *s = calloc(1, sizeof(N)); \
+		N *s = CONTAINER_MALLOC(sizeof(N)); \
 		if (s) { \
 			s->item = item; \
+			s->left = NULL; \
+			s->right = NULL; \
 		} \
 		return s; \
 	} \
@@ -29,13 +33,13 @@
 		if (s) { \
 			N##_free_all(s->left); \
 			N##_free_all(s->right); \
-			free(s); \
+			CONTAINER_FREE(s); \
 		} \
 	} \
 	\
 	N *N##_construct(T item, N *left, N *right) \
 	{ \
-		N *s = calloc(1, sizeof(N)); \
+		N *s = CONTAINER_MALLOC(sizeof(N)); \
 		if (s) { \
 			s->item = item; \
 			s->left = left; \
@@ -57,4 +61,273 @@
 	} \
 	struct N
 	
+
+#define TREE_FROZEN_ALIGN 64 /* alignment of the array of a frozen tree, also the size of the header of its image */
+#define TREE_FROZEN_MAGIC 0x5a465254UL /* the first word of an image, "TRFZ" in little endian */
+#define TREE_FROZEN_PREFETCH_LEVELS 4 /* how many levels below the current node a search prefetches */
+
+#ifdef __GNUC__
+#define TREE_FROZEN_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define TREE_FROZEN_PREFETCH(p) ((void)0)
+#endif
+
+#define TREE_FROZEN_PROTO(T, N) \
+	typedef struct N##_frozen N##_frozen; \
+	typedef container_size N##_frozen_iterator; \
+	N##_frozen *N##_freeze(const N *tree); \
+	int N##_freeze_init(N##_frozen *f, const N *tree); \
+	void N##_frozen_free(N##_frozen *f); \
+	void N##_frozen_destroy(N##_frozen *f); \
+	container_size N##_frozen_size(const N##_frozen *f); \
+	N##_frozen_iterator N##_frozen_find(const N##_frozen *f, T key); \
+	N##_frozen_iterator N##_frozen_lower_bound(const N##_frozen *f, T key); \
+	N##_frozen_iterator N##_frozen_iterate(const N##_frozen *f); \
+	int N##_frozen_next(const N##_frozen *f, N##_frozen_iterator *iter); \
+	int N##_frozen_prev(const N##_frozen *f, N##_frozen_iterator *iter); \
+	T N##_frozen_get_at(const N##_frozen *f, N##_frozen_iterator iter); \
+	size_t N##_frozen_image_size(const N##_frozen *f); \
+	void N##_frozen_save(const N##_frozen *f, void *image); \
+	int N##_frozen_view(N##_frozen *f, const void *image, size_t size)
+
+/*
+ * defines N##_frozen, a read-only copy of a TREE N used as a binary search
+ * tree ordered by int CMP(T a, T b) (which compares like in ALIST_SORT and is
+ * expanded in the generated code); the items are stored in one array in
+ * Eytzinger (breadth-first) order, the children of the item at k are at 2k and
+ * 2k+1, so a search needs no pointers and the top levels share cache lines
+ */
+#define TREE_FROZEN(T, N, CMP) \
+	struct N##_frozen { container_size len; T const *arr; void *mem; }; \
+	N##_frozen *N##_freeze(const N *tree) \
+	{ \
+		N##_frozen *f = CONTAINER_MALLOC(sizeof(N##_frozen)); \
+		if (f && !N##_freeze_init(f, tree)) { \
+			CONTAINER_FREE(f); \
+			return NULL; \
+		} \
+		return f; \
+	} \
+	\
+	/* \
+	 * copies the items of the tree under node in order to *out, walking it \
+	 * without recursion (an unbalanced tree may be deep); returns their \
+	 * number, or -1 on malloc failure or if they aren't sorted \
+	 */ \
+	container_size N##_frozen_collect_(const N *node, T **out) \
+	{ \
+		const N **stack = NULL, **new_stack; \
+		T *sorted = NULL; \
+		T *new_sorted; \
+		container_size top = 0, stack_cap = 0, len = 0, cap = 0; \
+		int ok = 1; \
+		while (ok && (node || top > 0)) { \
+			for (; node; node = node->left) { \
+				if (top == stack_cap) { \
+					stack_cap = stack_cap ? CONTAINER_GROW(stack_cap) : 32; \
+					new_stack = top < stack_cap && !CONTAINER_OVERFLOWS(stack_cap, sizeof(const N *)) ? \
+						CONTAINER_REALLOC((void *)stack, stack_cap * sizeof(const N *)) : NULL; \
+					if (!new_stack) { \
+						ok = 0; \
+						break; \
+					} \
+					stack = new_stack; \
+				} \
+				stack[top++] = node; \
+			} \
+			if (!ok) break; \
+			node = stack[--top]; \
+			if (len > 0 && CMP(node->item, sorted[len - 1]) < 0) { \
+				ok = 0; \
+				break; \
+			} \
+			if (len == cap) { \
+				cap = cap ? CONTAINER_GROW(cap) : 32; \
+				new_sorted = len < cap && !CONTAINER_OVERFLOWS(cap, sizeof(T)) ? \
+					CONTAINER_REALLOC(sorted, cap * sizeof(T)) : NULL; \
+				if (!new_sorted) { \
+					ok = 0; \
+					break; \
+				} \
+				sorted = new_sorted; \
+			} \
+			sorted[len++] = node->item; \
+			node = node->right; \
+		} \
+		CONTAINER_FREE((void *)stack); \
+		if (!ok) { \
+			CONTAINER_FREE(sorted); \
+			return -1; \
+		} \
+		*out = sorted; \
+		return len; \
+	} \
+	\
+	/* returns 0 on malloc failure or if tree isn't ordered by CMP */ \
+	int N##_freeze_init(N##_frozen *f, const N *tree) \
+	{ \
+		T *sorted = NULL; \
+		T *arr; \
+		container_size len = N##_frozen_collect_(tree, &sorted), i, k; \
+		if (len < 0) return 0; \
+		/* the searches compute 2k+1 for k up to len */ \
+		if (len > CONTAINER_SIZE_MAX / 2 || CONTAINER_OVERFLOWS(len + 1, sizeof(T)) \
+				|| (len + 1) * sizeof(T) > (size_t)-1 - (TREE_FROZEN_ALIGN - 1)) { \
+			CONTAINER_FREE(sorted); \
+			return 0; \
+		} \
+		f->mem = CONTAINER_MALLOC((len + 1) * sizeof(T) + (TREE_FROZEN_ALIGN - 1)); \
+		if (!f->mem) { \
+			CONTAINER_FREE(sorted); \
+			return 0; \
+		} \
+		arr = (T *)(((uintptr_t)f->mem + (TREE_FROZEN_ALIGN - 1)) & ~(uintptr_t)(TREE_FROZEN_ALIGN - 1)); \
+		/* the unused slot 0 is zeroed, so that saved images don't depend on memory contents */ \
+		memset((void *)arr, 0, sizeof(T)); \
+		f->arr = arr; \
+		f->len = len; \
+		/* the positions of an in-order walk of the array take the sorted items */ \
+		k = N##_frozen_iterate(f); \
+		for (i = 0; N##_frozen_next(f, &k); ++i) { \
+			arr[k] = sorted[i]; \
+		} \
+		CONTAINER_FREE(sorted); \
+		return 1; \
+	} \
+	\
+	void N##_frozen_free(N##_frozen *f) \
+	{ \
+		N##_frozen_destroy(f); \
+		CONTAINER_FREE(f); \
+	} \
+	\
+	/* frees the array unless it's a view of an image */ \
+	void N##_frozen_destroy(N##_frozen *f) \
+	{ \
+		CONTAINER_FREE(f->mem); \
+	} \
+	\
+	container_size N##_frozen_size(const N##_frozen *f) \
+	{ \
+		return f->len; \
+	} \
+	\
+	/* \
+	 * the comparison picks the child to go to without a branch, and the \
+	 * descendants TREE_FROZEN_PREFETCH_LEVELS levels down (adjacent in the \
+	 * array) are prefetched, so the loads of several levels overlap \
+	 */ \
+	N##_frozen_iterator N##_frozen_lower_bound(const N##_frozen *f, T key) \
+	{ \
+		container_size k = 1; \
+		while (k <= f->len) { \
+			if (k <= f->len >> TREE_FROZEN_PREFETCH_LEVELS) { \
+				TREE_FROZEN_PREFETCH(&f->arr[k << TREE_FROZEN_PREFETCH_LEVELS]); \
+			} \
+			k = 2 * k + (CMP(f->arr[k], key) < 0); \
+		} \
+		/* undo the right turns after the last left one, and that left turn */ \
+		while (k & 1) { \
+			k >>= 1; \
+		} \
+		return k >> 1; \
+	} \
+	\
+	N##_frozen_iterator N##_frozen_find(const N##_frozen *f, T key) \
+	{ \
+		container_size k = N##_frozen_lower_bound(f, key); \
+		return k && CMP(f->arr[k], key) == 0 ? k : 0; \
+	} \
+	\
+	N##_frozen_iterator N##_frozen_iterate(const N##_frozen *f) \
+	{ \
+		(void)f; \
+		return 0; \
+	} \
+	\
+	/* moves to the in-order successor; from 0 to the first item, after the last one to 0 */ \
+	int N##_frozen_next(const N##_frozen *f, N##_frozen_iterator *iter) \
+	{ \
+		container_size k = *iter; \
+		if (k == 0 || k <= (f->len - 1) / 2) { \
+			/* the leftmost item of the right subtree (of the root for 0) */ \
+			k = k ? 2 * k + 1 : (f->len > 0); \
+			while (k && k <= f->len / 2) { \
+				k *= 2; \
+			} \
+		} else { \
+			/* up to the first ancestor whose left subtree this is */ \
+			while (k & 1) { \
+				k >>= 1; \
+			} \
+			k >>= 1; \
+		} \
+		*iter = k; \
+		return k != 0; \
+	} \
+	\
+	/* moves to the in-order predecessor; from 0 to the last item, before the first one to 0 */ \
+	int N##_frozen_prev(const N##_frozen *f, N##_frozen_iterator *iter) \
+	{ \
+		container_size k = *iter; \
+		if (k == 0 || k <= f->len / 2) { \
+			k = k ? 2 * k : (f->len > 0); \
+			while (k && k <= (f->len - 1) / 2) { \
+				k = 2 * k + 1; \
+			} \
+		} else { \
+			while (k && !(k & 1)) { \
+				k >>= 1; \
+			} \
+			k >>= 1; \
+		} \
+		*iter = k; \
+		return k != 0; \
+	} \
+	\
+	T N##_frozen_get_at(const N##_frozen *f, N##_frozen_iterator iter) \
+	{ \
+		return f->arr[iter]; \
+	} \
+	\
+	/* the size of the image written by N##_frozen_save: a header and the array */ \
+	size_t N##_frozen_image_size(const N##_frozen *f) \
+	{ \
+		return TREE_FROZEN_ALIGN + (f->len + 1) * sizeof(T); \
+	} \
+	\
+	void N##_frozen_save(const N##_frozen *f, void *image) \
+	{ \
+		uint32_t header[4]; \
+		header[0] = TREE_FROZEN_MAGIC; \
+		header[1] = (uint32_t)sizeof(T); \
+		header[2] = (uint32_t)f->len; \
+		header[3] = (uint32_t)((size_t)f->len >> 16 >> 16); \
+		memset(image, 0, TREE_FROZEN_ALIGN); \
+		memcpy(image, header, sizeof(header)); \
+		memcpy((char *)image + TREE_FROZEN_ALIGN, f->arr, (f->len + 1) * sizeof(T)); \
+	} \
+	\
+	/* \
+	 * makes f a frozen tree using the array in an image of size bytes (e.g. a \
+	 * mmap'ed file), without copying it; returns 0 if it isn't an image of a \
+	 * tree of T saved on the same kind of platform \
+	 */ \
+	int N##_frozen_view(N##_frozen *f, const void *image, size_t size) \
+	{ \
+		uint32_t header[4]; \
+		size_t len; \
+		if (size < TREE_FROZEN_ALIGN) return 0; \
+		memcpy(header, image, sizeof(header)); \
+		if (header[0] != TREE_FROZEN_MAGIC || header[1] != sizeof(T)) return 0; \
+		if (header[3] && sizeof(size_t) <= 4) return 0; \
+		len = (size_t)header[2] | (size_t)header[3] << 16 << 16; \
+		if (len > CONTAINER_SIZE_MAX / 2 || len >= (size - TREE_FROZEN_ALIGN) / sizeof(T)) return 0; \
+		f->len = (container_size)len; \
+		f->arr = (T const *)(const void *)((const char *)image + TREE_FROZEN_ALIGN); \
+		f->mem = NULL; \
+		return 1; \
+	} \
+	struct N##_frozen /* to avoid extra semicolon outside of a function */
+
 #endif
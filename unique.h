@@ -2,6 +2,8 @@
 #define UNIQUE_H_INCLUDED 1
 
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define UNIQUE(T, N) \
 	/* The main data container for unique pointers */ \
@@ -78,4 +80,286 @@
 #define unique(OUTTYPE, NAME, DTOR ) _unique_(OUTTYPE) OUTTYPE##_unique_data_t NAME = \
                                     { .released = false, .data = NULL, .dtor = DTOR }; NAME.data
 
+/* The chunks of a scoped arena, the memory handed out follows the header */
+typedef struct scoped_arena_chunk {
+	struct scoped_arena_chunk *prev;
+	char *end;
+} scoped_arena_chunk_t;
+
+/* A bump allocator whose memory is freed all at once, at the end of the scope
+ * declaring it with scoped_arena(). While it exists, it's the current arena
+ * of its thread, replacing the one of the enclosing scope */
+typedef struct scoped_arena {
+	char *ptr;
+	char *end;
+	/* the blocks below it were allocated before the last checkpoint, so they
+	 * can't grow in place or be given back without overlapping what rewinding
+	 * frees */
+	char *floor;
+	scoped_arena_chunk_t *chunk;
+	size_t chunk_size;
+	struct scoped_arena *parent;
+} scoped_arena_t;
+
+/* A position in an arena to rewind it to */
+typedef struct scoped_arena_mark {
+	scoped_arena_chunk_t *chunk;
+	char *ptr;
+	char *floor;
+} scoped_arena_mark_t;
+
+/* The header of the blocks handed to containers by scoped_arena_malloc,
+ * its size keeps the alignment of malloc */
+typedef union scoped_arena_header {
+	struct {
+		size_t size;
+		scoped_arena_t *arena;
+	} h;
+	long double ld;
+	void *p;
+	long long ll;
+} scoped_arena_header_t;
+
+#define SCOPED_ARENA_ALIGN sizeof(scoped_arena_header_t)
+#define SCOPED_ARENA_ROUND(n) (((n) + SCOPED_ARENA_ALIGN - 1) & ~(SCOPED_ARENA_ALIGN - 1))
+
+/* The current arena of the thread. Defined weak, so that all translation
+ * units including this header share one */
+__attribute__((weak)) __thread scoped_arena_t *scoped_arena_current_ = NULL;
+
+static inline scoped_arena_t *scoped_arena_current( void ){
+	return scoped_arena_current_;
+}
+
+/* Adds a chunk with room for at least size bytes, returns 0 on malloc failure */
+static inline int scoped_arena_grow( scoped_arena_t *a, size_t size ){
+	scoped_arena_chunk_t *chunk;
+	size_t bytes = SCOPED_ARENA_ROUND( sizeof( scoped_arena_chunk_t ));
+
+	if ( size > (size_t)-1 - bytes ){
+		return 0;
+	}
+
+	bytes += size > a->chunk_size ? size : a->chunk_size;
+	chunk = malloc( bytes );
+	if ( !chunk ){
+		return 0;
+	}
+
+	chunk->prev = a->chunk;
+	chunk->end = (char *)chunk + bytes;
+	a->chunk = chunk;
+	a->ptr = (char *)chunk + SCOPED_ARENA_ROUND( sizeof( scoped_arena_chunk_t ));
+	a->end = chunk->end;
+	a->floor = a->ptr;
+
+	/* each chunk is twice as big as the last one, so there are few of them */
+	if ( a->chunk_size <= (size_t)-1 / 2 ){
+		a->chunk_size *= 2;
+	}
+
+	return 1;
+}
+
+/* Returns size bytes aligned like malloc's, NULL on malloc failure */
+static inline void *scoped_arena_alloc( scoped_arena_t *a, size_t size ){
+	void *ret;
+
+	if ( size > (size_t)-1 - SCOPED_ARENA_ALIGN ){
+		return NULL;
+	}
+
+	size = SCOPED_ARENA_ROUND( size );
+	if ( (size_t)( a->end - a->ptr ) < size && !scoped_arena_grow( a, size )){
+		return NULL;
+	}
+
+	ret = a->ptr;
+	a->ptr += size;
+
+	return ret;
+}
+
+static inline scoped_arena_mark_t scoped_arena_checkpoint( scoped_arena_t *a ){
+	scoped_arena_mark_t ret = { a->chunk, a->ptr, a->floor };
+
+	a->floor = a->ptr;
+
+	return ret;
+}
+
+/* Frees everything allocated from a since mark was taken, in O(1) unless
+ * chunks were added since */
+static inline void scoped_arena_rewind( scoped_arena_t *a, scoped_arena_mark_t mark ){
+	scoped_arena_chunk_t *prev;
+
+	while ( a->chunk != mark.chunk ){
+		prev = a->chunk->prev;
+		free( a->chunk );
+		a->chunk = prev;
+	}
+
+	a->ptr = mark.ptr;
+	a->end = a->chunk ? a->chunk->end : NULL;
+	a->floor = mark.floor;
+}
+
+/* Returns an arena with a first chunk of size bytes (or none if size is 0 or
+ * malloc fails, allocations then add one) which is the current arena of the
+ * thread until scoped_arena_cleanup */
+static inline scoped_arena_t scoped_arena_begin( scoped_arena_t *a, size_t size ){
+	scoped_arena_t ret = { NULL, NULL, NULL, NULL, size > 0 ? size : 4096, scoped_arena_current_ };
+
+	if ( size > 0 ){
+		scoped_arena_grow( &ret, size );
+	}
+
+	scoped_arena_current_ = a;
+
+	return ret;
+}
+
+/* Frees all chunks of the arena and makes the arena of the enclosing scope current */
+static inline void scoped_arena_cleanup( scoped_arena_t *a ){
+	scoped_arena_mark_t start = { NULL, NULL, NULL };
+
+	scoped_arena_rewind( a, start );
+	scoped_arena_current_ = a->parent;
+}
+
+/* Rewinds the arena of a scoped_checkpoint() at the end of its scope */
+typedef struct scoped_arena_scope {
+	scoped_arena_t *arena;
+	scoped_arena_mark_t mark;
+} scoped_arena_scope_t;
+
+static inline scoped_arena_scope_t scoped_arena_scope_begin( scoped_arena_t *a ){
+	scoped_arena_scope_t ret = { a, scoped_arena_checkpoint( a )};
+
+	return ret;
+}
+
+static inline void scoped_arena_scope_cleanup( scoped_arena_scope_t *s ){
+	scoped_arena_rewind( s->arena, s->mark );
+}
+
+/* Makes a the current arena (malloc if NULL) until scoped_arena_use_cleanup,
+ * e.g. to grow a container that has to outlive the current arena */
+static inline scoped_arena_t *scoped_arena_use_begin( scoped_arena_t *a ){
+	scoped_arena_t *ret = scoped_arena_current_;
+
+	scoped_arena_current_ = a;
+
+	return ret;
+}
+
+static inline void scoped_arena_use_cleanup( scoped_arena_t **prev ){
+	scoped_arena_current_ = *prev;
+}
+
+/* The allocator for containers, see CONTAINER_MALLOC in container.h. Blocks
+ * come from the current arena or from malloc if there's none, and remember
+ * which, so they can be freed and grown after the arena has changed; freeing
+ * the last block of an arena gives its memory back if it was allocated since
+ * the last checkpoint, other blocks stay until the arena is rewound or goes
+ * out of scope */
+static inline void *scoped_arena_malloc( size_t size ){
+	scoped_arena_header_t *h;
+	scoped_arena_t *a = scoped_arena_current_;
+
+	if ( size > (size_t)-1 - sizeof( scoped_arena_header_t )){
+		return NULL;
+	}
+
+	if ( a ){
+		h = scoped_arena_alloc( a, sizeof( scoped_arena_header_t ) + size );
+	} else {
+		h = malloc( sizeof( scoped_arena_header_t ) + size );
+	}
+
+	if ( !h ){
+		return NULL;
+	}
+
+	h->h.size = size;
+	h->h.arena = a;
+
+	return h + 1;
+}
+
+static inline void scoped_arena_free( void *p ){
+	scoped_arena_header_t *h;
+
+	if ( !p ){
+		return;
+	}
+
+	h = (scoped_arena_header_t *)p - 1;
+	if ( !h->h.arena ){
+		free( h );
+
+	} else if ( (char *)p + SCOPED_ARENA_ROUND( h->h.size ) == h->h.arena->ptr
+			&& (char *)h >= h->h.arena->floor ){
+		h->h.arena->ptr = (char *)h;
+	}
+}
+
+static inline void *scoped_arena_realloc( void *p, size_t size ){
+	scoped_arena_header_t *h;
+	scoped_arena_t *a;
+	void *ret;
+
+	if ( !p ){
+		return scoped_arena_malloc( size );
+	}
+
+	h = (scoped_arena_header_t *)p - 1;
+	a = h->h.arena;
+	if ( size > (size_t)-1 - SCOPED_ARENA_ALIGN - sizeof( scoped_arena_header_t )){
+		return NULL;
+	}
+
+	if ( !a ){
+		h = realloc( h, sizeof( scoped_arena_header_t ) + size );
+		if ( !h ){
+			return NULL;
+		}
+
+		h->h.size = size;
+		return h + 1;
+	}
+
+	/* the last block of its arena grows or shrinks in place if it fits and
+	 * was allocated since the last checkpoint */
+	if ( (char *)p + SCOPED_ARENA_ROUND( h->h.size ) == a->ptr && (char *)h >= a->floor
+			&& SCOPED_ARENA_ROUND( size ) <= (size_t)( a->end - (char *)p )){
+		a->ptr = (char *)p + SCOPED_ARENA_ROUND( size );
+		h->h.size = size;
+		return p;
+	}
+
+	if ( size <= h->h.size ){
+		return p;
+	}
+
+	/* the other blocks move within the arena they came from */
+	ret = scoped_arena_alloc( a, sizeof( scoped_arena_header_t ) + size );
+	if ( !ret ){
+		return NULL;
+	}
+
+	memcpy( (scoped_arena_header_t *)ret + 1, p, h->h.size );
+	((scoped_arena_header_t *)ret)->h.size = size;
+	((scoped_arena_header_t *)ret)->h.arena = a;
+
+	return (scoped_arena_header_t *)ret + 1;
+}
+
+#define _scoped_arena_ __attribute__((cleanup(scoped_arena_cleanup)))
+#define scoped_arena(NAME, SIZE) _scoped_arena_ scoped_arena_t NAME = scoped_arena_begin( &NAME, SIZE )
+#define _scoped_checkpoint_ __attribute__((cleanup(scoped_arena_scope_cleanup)))
+#define scoped_checkpoint(NAME, ARENA) _scoped_checkpoint_ scoped_arena_scope_t NAME = scoped_arena_scope_begin( ARENA )
+#define _scoped_arena_use_ __attribute__((cleanup(scoped_arena_use_cleanup)))
+#define scoped_arena_use(NAME, ARENA) _scoped_arena_use_ scoped_arena_t *NAME = scoped_arena_use_begin( ARENA )
+
 #endif
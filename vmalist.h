@@ -0,0 +1,81 @@
+/* vmalist.h: array lists in a reserved range of virtual memory (POSIX only) */
+
+#ifndef VMALIST_H_INCLUDED
+#define VMALIST_H_INCLUDED 1
+
+/*
+ * mmap, madvise and MAP_ANONYMOUS are not part of ANSI C, compile with e.g.
+ * -D_DEFAULT_SOURCE when using -ansi
+ */
+#include <sys/mman.h>
+#include <unistd.h>
+#include "alist.h"
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* don't count the reservation against the commit limit where that's possible */
+#ifdef MAP_NORESERVE
+#define VMALIST_MAP_FLAGS (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE)
+#else
+#define VMALIST_MAP_FLAGS (MAP_PRIVATE | MAP_ANONYMOUS)
+#endif
+
+/*
+ * defines the functions of ALIST_PROTO(T, N) for an array list which reserves
+ * address space for RESERVE elements of type T when created and only commits
+ * pages as the capacity grows; arr never moves, so growing never copies the
+ * elements and pointers to them stay valid, and shrinking with N##_resize
+ * returns the pages past the new capacity to the OS; the capacity is rounded
+ * up to whole pages and can't exceed RESERVE, N##_insert fails once the list
+ * has RESERVE elements
+ */
+#define ALIST_VM(T, N, RESERVE) \
+	struct N { container_size cap; container_size len; T *arr; size_t reserved; size_t committed; }; \
+	size_t N##_page_round_(size_t bytes) \
+	{ \
+		size_t page; \
+		page = sysconf(_SC_PAGESIZE); \
+		return (bytes + page - 1) / page * page; \
+	} \
+	int N##_realloc_(N *s, container_size size) \
+	{ \
+		size_t bytes; \
+		if (size > (RESERVE)) { \
+			if (s->committed >= (RESERVE) * sizeof(T)) return 0; \
+			size = (RESERVE); \
+		} \
+		bytes = N##_page_round_(size * sizeof(T)); \
+		if (bytes > s->committed) { \
+			if (mprotect((char *)s->arr + s->committed, bytes - s->committed, PROT_READ | PROT_WRITE)) return 0; \
+		} else if (bytes < s->committed) { \
+			madvise((char *)s->arr + bytes, s->committed - bytes, MADV_DONTNEED); \
+			mprotect((char *)s->arr + bytes, s->committed - bytes, PROT_NONE); \
+		} \
+		s->committed = bytes; \
+		/* the rest of the last page is usable as well */ \
+		s->cap = bytes / sizeof(T) < (RESERVE) ? bytes / sizeof(T) : (RESERVE); \
+		return 1; \
+	} \
+	int N##_alloc_(N *s, container_size size) \
+	{ \
+		void *arr; \
+		s->reserved = N##_page_round_((size_t)(RESERVE) * sizeof(T)); \
+		s->committed = 0; \
+		arr = mmap(NULL, s->reserved, PROT_NONE, VMALIST_MAP_FLAGS, -1, 0); \
+		if (arr == MAP_FAILED) return 0; \
+		s->arr = arr; \
+		if (!N##_realloc_(s, size)) { \
+			munmap(arr, s->reserved); \
+			return 0; \
+		} \
+		return 1; \
+	} \
+	void N##_dealloc_(N *s) \
+	{ \
+		munmap(s->arr, s->reserved); \
+	} \
+	ALIST_BODY_(T, N, 8)
+
+#endif /* ifndef VMALIST_H_INCLUDED */